@@ -12,38 +12,37 @@
 
 #include "task_event.h"
 
-uint8 statistics_task_id;                    //记录统计任务的任务ID
+struct osal_tcb *statistics_task;        //记录统计任务的任务指针
 
 /**
  * @brief 任务初始化
- * @param task_id [初始化时分配给当前任务的任务ID，标记区分每一个任务]
+ * @param task [初始化时分配给当前任务的任务指针，标记区分每一个任务]
  */
-void statistics_task_init(uint8 task_id)
+void statistics_task_init(struct osal_tcb *task)
 {
-    statistics_task_id = task_id;
+    statistics_task = task;
 }
 
 /**
  * @brief 当前任务的事件回调处理函数
- * @param task_id       [任务ID]
+ * @param task          [任务指针]
  * @param task_event    [收到的本任务事件]
- * @return uint16       [未处理的事件]
+ * @return osal_event_t [未处理的事件]
  */
-uint16 statistics_task_event_process(uint8 task_id, uint16 task_event)
+osal_event_t statistics_task_event_process(struct osal_tcb *task, osal_event_t task_event)
 {
     if(task_event & SYS_EVENT_MSG)       //判断是否为系统消息事件
     {
-        osal_sys_msg_t *msg_pkt;
-        msg_pkt = (osal_sys_msg_t *)osal_msg_receive(task_id);      //从消息队列获取一条消息
+        struct osal_msg_hdr *chain = osal_msg_receive_all(task);   //一次取出消息队列中的全部消息
+        general_msg_data_t *msg_pkt;
 
-        while(msg_pkt)
+        while((msg_pkt = (general_msg_data_t *)osal_msg_next(&chain)) != NULL)
         {
-            switch(msg_pkt->hdr.event)      //判断该消息事件类型
+            switch(msg_pkt->event)          //判断该消息事件类型
             {
                 case PRINTF_STATISTICS:
                 {
-                    int count = *(int*)(((general_msg_data_t*)msg_pkt)->data);
-                    printf("Statistics task receive print task printf count : %d\n", count);
+                    printf("Statistics task receive print task printf count : %d\n", msg_pkt->data);
                     break;
                 }
 
@@ -51,8 +50,7 @@ uint16 statistics_task_event_process(uint8 task_id, uint16 task_event)
                     break;
             }
 
-            osal_msg_deallocate((uint8 *)msg_pkt);                  //释放消息内存
-            msg_pkt = (osal_sys_msg_t *)osal_msg_receive(task_id);  //读取下一条消息
+            osal_msg_deallocate((uint8_t *)msg_pkt);                //释放消息内存
         }
 
         // return unprocessed events
@@ -9,32 +9,54 @@
  *
  */
 #include "osal.h"
+#include <stdatomic.h>
 #include <string.h>
 
-osal_msg_q_t osal_qHead;
+#if OSAL_MAX_CTX > 1
+#if OSAL_WORKERS || OSALMEM_PERSIST || OSALMEM_TCACHE
+#error "OSAL_WORKERS, OSALMEM_PERSIST and OSALMEM_TCACHE need OSAL_MAX_CTX 1"
+#endif
+
+_Thread_local osal_ctx_t osal_ctx_cur = OSAL_DEFAULT_CTX;
+#endif
+
+// 已创建的实例数量，默认实例总是存在；各实例有各自的临界区，不能用临界区保护，
+// 用原子操作更新
+static atomic_uint_fast8_t ctx_cnt = 1;
 
 /**
  * @brief 初始化系统，如线程表、内存管理系统的等
  *
- * @return uint8
+ * @return uint8 成功返回ZSUCCESS，静态任务超过OSAL_MAX_TASKS时返回OSAL_TOO_MANY_TASKS，
+ * 此时不能调用osal_run
  */
 uint8_t osal_init(void) {
   // 初始化动态内存分配器
   osal_mem_init();
 
-  // 初始化消息队列
-  osal_qHead = NULL;
-
-#if defined(OSAL_TOTAL_MEM)
-  osal_msg_cnt = 0;
-#endif
-
   // 初始化时钟
   osal_timer_init();
 
   // 初始化任务列表
   osal_task_init();
 
+#if OSAL_TASK_STATIC
+  // 加入静态定义的任务
+  if (osal_task_register_static() != OSAL_OK) {
+    return (OSAL_TOO_MANY_TASKS);
+  }
+#endif
+
+#if OSAL_MAX_CALLS
+  // 初始化调用表
+  osal_rpc_init();
+#endif
+
+#if OSAL_WORK_RING
+  // 初始化延迟工作队列
+  osal_work_init();
+#endif
+
   return (ZSUCCESS);
 }
 
@@ -47,11 +69,103 @@ void osal_run(void) {
   // 调用任务的初始化函数
   osal_task_runinit();
 
+#if OSAL_WORKERS
+  // 多线程调度任务
+  osal_task_run_workers();
+#else
   while (1) {
 
     // 运行任务
     osal_task_polling();
+
+#if OSALMEM_DEFERRED_FREE
+    // 批量回收中断或其他线程延迟释放的内存
+    osal_mem_drain();
+#endif
   }
+#endif
+}
+
+/**
+ * @brief 创建一个新的内核实例
+ *
+ * @return osal_ctx_t 实例，超过OSAL_MAX_CTX时返回OSAL_INVALID_CTX
+ */
+osal_ctx_t osal_ctx_create(void) {
+  uint_fast8_t cnt = atomic_load_explicit(&ctx_cnt, memory_order_relaxed);
+
+  do {
+    if (cnt >= OSAL_MAX_CTX) {
+      return OSAL_INVALID_CTX;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(
+      &ctx_cnt, &cnt, cnt + 1, memory_order_acq_rel, memory_order_relaxed));
+
+  return (osal_ctx_t)cnt;
+}
+
+/**
+ * @brief 将当前线程绑定到实例，之后当前线程调用的osal接口都作用于该实例
+ *
+ * @param ctx 实例
+ */
+void osal_ctx_bind(osal_ctx_t ctx) {
+#if OSAL_MAX_CTX > 1
+  if (ctx < atomic_load_explicit(&ctx_cnt, memory_order_acquire)) {
+    osal_ctx_cur = ctx;
+  }
+#else
+  (void)ctx;
+#endif
+}
+
+/**
+ * @brief 获取已创建的实例数量，包括默认实例
+ *
+ * @return uint8_t 实例数量
+ */
+uint8_t osal_ctx_count(void) {
+  return (uint8_t)atomic_load_explicit(&ctx_cnt, memory_order_acquire);
+}
+
+/**
+ * @brief 将当前线程绑定到实例并初始化实例，同osal_init
+ *
+ * @param ctx 实例
+ * @return uint8_t 成功返回ZSUCCESS
+ */
+uint8_t osal_ctx_init(osal_ctx_t ctx) {
+  osal_ctx_bind(ctx);
+  return osal_init();
+}
+
+/**
+ * @brief 将当前线程绑定到实例并运行实例，同osal_run，此函数不会返回
+ *
+ * @param ctx 实例
+ */
+void osal_ctx_run(osal_ctx_t ctx) {
+  osal_ctx_bind(ctx);
+  osal_run();
+}
+
+/**
+ * @brief 更新所有实例的系统时间，多实例时tick中断或tick线程调用此函数代替osal_tick
+ *
+ * @param ms 时间，单位ms
+ */
+void osal_ctx_tick_all(uint16_t ms) {
+#if OSAL_MAX_CTX > 1
+  const osal_ctx_t self = osal_ctx_cur;
+  const osal_ctx_t cnt = osal_ctx_count();
+  for (osal_ctx_t ctx = 0; ctx < cnt; ctx++) {
+    osal_ctx_cur = ctx;
+    osal_tick(ms);
+  }
+  osal_ctx_cur = self;
+#else
+  osal_tick(ms);
+#endif
 }
 
 #if 0
@@ -11,16 +11,21 @@
 #pragma once
 
 #include "hal_types.h"
+#include "osal_co.h"
 #include "osal_config.h"
+#include "osal_ctx.h"
 #include "osal_memory.h"
 #include "osal_msg.h"
 #include "osal_port.h"
+#include "osal_rpc.h"
 #include "osal_task.h"
 #include "osal_timer.h"
 #include "osal_types.h"
+#include "osal_work.h"
 
-// extern osal_msg_q_t osal_qHead;
-extern uint8_t total_task_cnt; // 任务数量统计
+#if OSAL_TASK_STATIC
+#include "osal_tcb.h"
+#endif
 
 /**
  * @brief 初始化系统，如线程表、内存管理系统的等
@@ -0,0 +1,112 @@
+/**
+ * @file osal_co.h
+ * @author ljgabc
+ * @brief 无栈协程任务
+ * 任务处理函数用OSAL_CO_BEGIN和OSAL_CO_END包围后，可以在其中用OSAL_YIELD让出CPU、
+ * 用OSAL_AWAIT_EVENT等待事件、用OSAL_SLEEP延时，续点保存在任务控制块中，
+ * 下次调度时从续点继续执行，长时间的处理可以分段执行而不需要手写状态机。
+ * 注意：
+ * 1. 让出后局部变量不保留，需要跨越让出点的变量使用static变量或任务自己的上下文；
+ * 2. 协程中不能使用switch语句包含让出点，一行中只能有一个让出点；
+ * 3. 协程挂起期间收到的事件被保存，直到OSAL_AWAIT_EVENT取走，协程结束时未取走的事件被丢弃
+ * @version 0.1
+ * @date 2024-12-16
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "osal_config.h"
+#include "osal_task.h"
+#include "osal_timer.h"
+#include "osal_types.h"
+
+// 为1时开启协程任务
+#ifndef OSAL_COROUTINE
+#define OSAL_COROUTINE 0
+#endif
+
+#if OSAL_COROUTINE
+// 协程让出和延时使用的系统事件，开启后应用不能再使用此事件位，16位事件时为0x2000
+#define OSAL_SYS_EVENT_YIELD ((osal_event_t)1 << (OSAL_EVENT_BITS - 3))
+
+// 协程状态，保存在任务控制块中
+struct osal_co {
+  uint16_t line;       // 续点，0表示从头开始
+  osal_event_t events; // 挂起期间收到、还没有被等待取走的事件
+};
+
+/**
+ * @brief 获取任务的协程状态
+ *
+ * @param task 任务
+ * @return struct osal_co* 协程状态
+ */
+struct osal_co *osal_task_co(struct osal_tcb *task);
+
+/**
+ * @brief 协程开始，放在任务处理函数的开始位置
+ *
+ * @param co_task 任务处理函数的任务参数
+ * @param co_events 任务处理函数的事件参数
+ */
+#define OSAL_CO_BEGIN(co_task, co_events)                                      \
+  struct osal_tcb *const osal_co_task_ = (co_task);                            \
+  struct osal_co *const osal_co_ = osal_task_co(osal_co_task_);                \
+  osal_co_->events |= (osal_event_t)((co_events) & ~OSAL_SYS_EVENT_YIELD);     \
+  switch (osal_co_->line) {                                                    \
+  case 0:
+
+/**
+ * @brief 协程结束，放在任务处理函数的结束位置，下次调度时协程从头开始
+ *
+ */
+#define OSAL_CO_END()                                                          \
+  }                                                                            \
+  osal_co_->line = 0;                                                          \
+  osal_co_->events = 0;                                                        \
+  return 0
+
+/**
+ * @brief 让出CPU，其他就绪任务执行后从这里继续
+ *
+ */
+#define OSAL_YIELD()                                                           \
+  do {                                                                         \
+    osal_co_->line = __LINE__;                                                 \
+    return OSAL_SYS_EVENT_YIELD;                                               \
+  case __LINE__:;                                                              \
+  } while (0)
+
+/**
+ * @brief 等待事件，mask中任一事件到达后取走这些事件并继续
+ *
+ * @param mask 等待的事件
+ */
+#define OSAL_AWAIT_EVENT(mask)                                                 \
+  do {                                                                         \
+    osal_co_->line = __LINE__;                                                 \
+  case __LINE__:                                                               \
+    if ((osal_co_->events & (mask)) == 0) {                                    \
+      return 0;                                                                \
+    }                                                                          \
+    osal_co_->events &= (osal_event_t)~(mask);                                 \
+  } while (0)
+
+/**
+ * @brief 延时，期间其他任务正常执行，使用任务的OSAL_SYS_EVENT_YIELD定时器
+ *
+ * @param ms 延时时间，单位ms
+ */
+#define OSAL_SLEEP(ms)                                                         \
+  do {                                                                         \
+    osal_start_timer(osal_co_task_, OSAL_SYS_EVENT_YIELD, (ms), true);         \
+    osal_co_->line = __LINE__;                                                 \
+    return 0;                                                                  \
+  case __LINE__:                                                               \
+    if (osal_timer_get_timeout(osal_co_task_, OSAL_SYS_EVENT_YIELD) != 0) {    \
+      return 0;                                                                \
+    }                                                                          \
+  } while (0)
+#endif
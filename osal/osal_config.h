@@ -2,7 +2,35 @@
 
 #define OSAL_MAX_TASKS 32
 #define OSAL_MAX_TIMERS 32
+#define OSAL_MAX_TOPICS 8 // 消息发布订阅的主题数量
+#define OSAL_MAX_CALLS 0 // 同时等待应答的请求/应答调用数量，为0时不使用
+#define OSAL_MAX_CTX 1 // 内核实例数量，大于1时可以在多个线程中各运行一个独立的实例
+#define OSAL_WORKERS 0 // 工作线程数量，大于0时多线程并行执行任务，仅用于Linux平台
+#define OSAL_WORK_RING 0 // 延迟工作队列容量，必须是2的幂，为0时不使用
+#define OSAL_WORK_PRIORITY 255 // 执行延迟工作的内部任务优先级
+#define OSAL_SCHED_EDF 0 // 定义有效则开启最早截止时间优先调度，带截止时间的事件优先于静态优先级
+#define OSAL_TASK_RR 0 // 定义有效则相同优先级的就绪任务轮流执行，避免忙任务饿死同级任务
+#define OSAL_EVENT_BUDGET 0 // 每次调度最多交给处理函数的事件数量，为0时不限制
+#define OSAL_EVENT_BITS 16 // 任务事件位宽，可选16、32、64
+#define OSAL_EVENT_ATOMIC HAL_HAS_ATOMICS // 定义有效则事件的置位、清除和读取使用原子操作，不进入临界区
+#define OSAL_COROUTINE 0 // 定义有效则开启协程任务，处理函数可以让出、等待事件和延时
+#define OSAL_TASK_STATIC 0 // 定义有效则可以用OSAL_TASK_DEFINE静态定义任务，任务控制块放在osal_tasks段中，不占用堆
+#define OSAL_EVENT_TABLE 0 // 定义有效则可以为每个事件位注册处理函数，一次调度处理所有事件
+
+#define OSAL_MSG_LANES 2 // 每个任务消息队列的优先级通道数量
+
+#define OSAL_MSG_MPSC 0 // 定义有效则开启无锁消息投递，其他线程投递消息和事件不进入临界区
+
+#define OSAL_EVT_RING 0 // 每个任务内嵌的小数据事件队列深度，为0时不使用，小数据事件不申请内存
 
 #define MAXMEMHEAP 1024 * 6 // 内存池大小，单位字节
 
-#define OSALMEM_METRICS 0 // 定义有效则开启内存统计
\ No newline at end of file
+#define OSALMEM_METRICS 0 // 定义有效则开启内存统计
+
+#define OSALMEM_DEFERRED_FREE 0 // 定义有效则开启延迟释放，内存释放只需一次原子操作
+
+#define OSALMEM_TCACHE 0 // 定义有效则开启线程缓存，多线程申请内存时减少临界区竞争
+
+#define OSALMEM_HANDLE 0 // 定义有效则开启句柄内存，空闲时整理内存碎片
+
+#define OSALMEM_PERSIST 0 // 定义有效则开启持久化堆，重启后可以恢复持久保存的数据
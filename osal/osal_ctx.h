@@ -0,0 +1,84 @@
+/**
+ * @file osal_ctx.h
+ * @author ljgabc
+ * @brief 内核实例
+ * 每个内核实例有独立的任务、定时器、消息、调用表和内存堆，实例之间不共享任何状态，
+ * 可以在一个进程中每个线程运行一个实例。线程调用osal_ctx_bind绑定实例后，
+ * 所有osal接口都作用于该实例，没有绑定的线程使用默认实例。
+ * 不同实例的任务之间不能直接收发消息，消息缓冲区只能在申请它的实例中释放。
+ * 置位事件、发送和投递消息时任务必须属于当前线程绑定的实例，否则触发断言；
+ * 只有osal_event_post可以跨实例调用
+ * @version 0.1
+ * @date 2024-12-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "osal_config.h"
+#include "osal_types.h"
+
+// 内核实例数量，为1时只有默认实例，不产生额外开销
+#ifndef OSAL_MAX_CTX
+#define OSAL_MAX_CTX 1
+#endif
+
+// 内核实例
+typedef uint8_t osal_ctx_t;
+
+#define OSAL_DEFAULT_CTX 0    // 默认实例
+#define OSAL_INVALID_CTX 0xFF // 无效实例
+
+#if OSAL_MAX_CTX > 1
+// 当前线程绑定的实例
+extern _Thread_local osal_ctx_t osal_ctx_cur;
+
+// 获取当前线程绑定的实例
+#define osal_ctx_current() (osal_ctx_cur)
+#else
+#define osal_ctx_current() OSAL_DEFAULT_CTX
+#endif
+
+/**
+ * @brief 创建一个新的内核实例
+ *
+ * @return osal_ctx_t 实例，超过OSAL_MAX_CTX时返回OSAL_INVALID_CTX
+ */
+osal_ctx_t osal_ctx_create(void);
+
+/**
+ * @brief 将当前线程绑定到实例，之后当前线程调用的osal接口都作用于该实例
+ *
+ * @param ctx 实例
+ */
+void osal_ctx_bind(osal_ctx_t ctx);
+
+/**
+ * @brief 获取已创建的实例数量，包括默认实例
+ *
+ * @return uint8_t 实例数量
+ */
+uint8_t osal_ctx_count(void);
+
+/**
+ * @brief 将当前线程绑定到实例并初始化实例，同osal_init
+ *
+ * @param ctx 实例
+ * @return uint8_t 成功返回ZSUCCESS
+ */
+uint8_t osal_ctx_init(osal_ctx_t ctx);
+
+/**
+ * @brief 将当前线程绑定到实例并运行实例，同osal_run，此函数不会返回
+ *
+ * @param ctx 实例
+ */
+void osal_ctx_run(osal_ctx_t ctx);
+
+/**
+ * @brief 更新所有实例的系统时间，多实例时tick中断或tick线程调用此函数代替osal_tick
+ *
+ * @param ms 时间，单位ms
+ */
+void osal_ctx_tick_all(uint16_t ms);
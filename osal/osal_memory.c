@@ -19,6 +19,11 @@ extern "C" {
 #endif
 
 #include "osal.h"
+#include <string.h>
+
+#if OSALMEM_DEFERRED_FREE
+#include <stdatomic.h>
+#endif
 
 #define OSALMEM_IN_USE (0x1 << 31)
 
@@ -109,23 +114,77 @@ extern "C" {
 typedef union {
   uint32_t val;
   struct {
-    // 低31位表示内存块的大小(包括头部分)
-    unsigned len : 31;
+    // 低28位表示内存块的大小(包括头部分)
+    unsigned len : 28;
+    // 表示内存块已经压入延迟释放栈，等待批量归还
+    unsigned deferred : 1;
+    // 表示内存块是否需要持久保存，重启后恢复堆时会保留该内存块
+    unsigned persist : 1;
+    // 次高位表示内存块是否可以被整理移动，只有通过句柄申请的内存块才能移动
+    unsigned movable : 1;
     // 最高位表示内存块是否被使用
     unsigned inUse : 1;
   };
 } osal_mem_hdr_t;
 
-static osal_mem_hdr_t theHeap[MAXMEMHEAP / OSALMEM_HDRSZ];
-static osal_mem_hdr_t *ff1; // First free block in the small-block bucket.
-static uint8_t mem_stat;    // Discrete status flags: 0x01 = kicked.
+#if OSALMEM_PERSIST
+// 持久化区域的魔数，有效时说明区域中保存着上次运行的堆
+#define OSALMEM_PERSIST_MAGIC 0x4F534D50UL
 
-#if OSALMEM_METRICS
-static uint16_t blkMax;  // Max cnt of all blocks ever seen at once.
-static uint16_t blkCnt;  // Current cnt of all blocks.
-static uint16_t blkFree; // Current cnt of free blocks.
-static uint16_t memAlo;  // Current total memory allocated.
-static uint16_t memMax;  // Max total memory ever allocated at once.
+// 持久化区域头，紧跟在后面的是堆空间
+struct osal_mem_persist {
+  uint32_t magic;     // 堆格式化完成后才写入魔数
+  uint32_t version;   // OSALMEM_PERSIST_VERSION
+  uint32_t heap_size; // MAXMEMHEAP
+  uintptr_t base;     // 区域映射地址，地址变化后堆中的指针失效，不能恢复
+  struct {
+    uint32_t off;     // 数据区相对theHeap的字节偏移，0表示空
+    uint32_t version; // 根指针版本
+  } root[OSALMEM_PERSIST_ROOTS];
+};
+
+static struct osal_mem_persist *persist;
+static osal_mem_hdr_t *theHeap; // 指向持久化区域中的堆空间
+static bool mem_warm;           // 堆是从上次运行中恢复的
+#endif
+
+#if OSALMEM_DEFERRED_FREE
+// 延迟释放链表的结束标记
+#define OSALMEM_DEFER_NIL 0xFFFFFFFFUL
+
+// 内存块头中的deferred位
+#define OSALMEM_DEFERRED (0x1UL << 28)
+
+// 延迟释放链表的链接字段，存放在被释放块数据区的第一个字中，保存下一个块头的索引
+#define OSALMEM_DEFER_LINK(hdr) (*(uint32_t *)((hdr) + 1))
+
+#endif
+
+#if OSALMEM_TCACHE
+// 线程缓存的档位数量，第n档缓存长度不小于(n+1)*OSALMEM_HDRSZ的内存块
+#define OSALMEM_TCACHE_BINS (OSALMEM_TCACHE_MAXSZ / OSALMEM_HDRSZ)
+
+// 线程缓存，每个线程独享，存放最近释放的小内存块，块仍保持占用状态
+struct osal_mem_tcache {
+  uint8_t cnt[OSALMEM_TCACHE_BINS];
+  osal_mem_hdr_t *blk[OSALMEM_TCACHE_BINS][OSALMEM_TCACHE_CNT];
+};
+
+static _Thread_local struct osal_mem_tcache tcache;
+#endif
+
+#if OSALMEM_HANDLE
+// 句柄内存块数据区第一个字保存句柄表索引，整理时据此更新句柄表
+#define OSALMEM_HANDLE_ID(hdr) (*(uint32_t *)((hdr) + 1))
+
+// 句柄内存块交给用户的地址，跳过头部和句柄表索引
+#define OSALMEM_HANDLE_PTR(hdr) ((void *)((hdr) + 2))
+
+// 句柄表项
+struct osal_mem_handle {
+  osal_mem_hdr_t *hdr; // 内存块头，NULL表示句柄未使用
+  uint8_t lock;        // 锁定计数，锁定期间内存块不会被移动
+};
 #endif
 
 #if OSALMEM_PROFILER
@@ -136,10 +195,97 @@ static uint16_t memMax;  // Max total memory ever allocated at once.
  */
 static uint16_t proCnt[OSALMEM_PROMAX] = {
     OSALMEM_SMALL_BLKSZ, 48, 112, 176, 192, 224, 256, 65535};
-static uint16_t proCur[OSALMEM_PROMAX] = {0};
-static uint16_t proMax[OSALMEM_PROMAX] = {0};
-static uint16_t proTot[OSALMEM_PROMAX] = {0};
-static uint16_t proSmallBlkMiss;
+#endif
+
+#if OSALMEM_TRACE
+#include <stdio.h>
+
+// 内存申请释放记录的输出函数，可替换为串口等输出
+#ifndef OSALMEM_TRACE_PRINTF
+#define OSALMEM_TRACE_PRINTF printf
+#endif
+
+// 数据区相对theHeap的字节偏移，用于在记录中标识内存块
+#define OSALMEM_TRACE_OFFSET(ptr)                                              \
+  ((unsigned)((uint8_t *)(ptr) - (uint8_t *)theHeap))
+#endif
+
+// 内存管理器状态，每个内核实例独享一个堆
+struct osal_mem_state {
+#if !OSALMEM_PERSIST
+  osal_mem_hdr_t heap[MAXMEMHEAP / OSALMEM_HDRSZ];
+#endif
+  osal_mem_hdr_t *ff1; // First free block in the small-block bucket.
+  uint8_t mem_stat;    // Discrete status flags: 0x01 = kicked.
+#if OSALMEM_DEFERRED_FREE
+  atomic_uint_least32_t defer_head; // 延迟释放栈顶，保存块头在theHeap中的索引
+#endif
+#if OSALMEM_HANDLE
+  struct osal_mem_handle hnd_table[OSALMEM_HANDLE_MAX];
+  bool compact_pending; // 大块区域有内存释放，需要整理
+#endif
+#if OSALMEM_METRICS
+  uint16_t blkMax;  // Max cnt of all blocks ever seen at once.
+  uint16_t blkCnt;  // Current cnt of all blocks.
+  uint16_t blkFree; // Current cnt of free blocks.
+  uint16_t memAlo;  // Current total memory allocated.
+  uint16_t memMax;  // Max total memory ever allocated at once.
+#endif
+#if OSALMEM_PROFILER
+  uint16_t proCur[OSALMEM_PROMAX];
+  uint16_t proMax[OSALMEM_PROMAX];
+  uint16_t proTot[OSALMEM_PROMAX];
+  uint16_t proSmallBlkMiss;
+  uint16_t proSearchMax; // 分配时最多遍历过的内存块数量
+#endif
+#if OSALMEM_TRACE
+  uint8_t trace_mute; // osal_mem_kick内部的申请释放不记录
+#endif
+};
+
+#if OSALMEM_DEFERRED_FREE
+static struct osal_mem_state mem_state[OSAL_MAX_CTX] = {
+    [0 ... OSAL_MAX_CTX - 1] = {.defer_head = OSALMEM_DEFER_NIL}};
+#else
+static struct osal_mem_state mem_state[OSAL_MAX_CTX];
+#endif
+
+// 以下名称映射到当前内核实例的状态，内部代码保持不变
+#define OSALMEM_STATE (mem_state[osal_ctx_current()])
+#if !OSALMEM_PERSIST
+#define theHeap (OSALMEM_STATE.heap)
+#endif
+#define ff1 (OSALMEM_STATE.ff1)
+#define mem_stat (OSALMEM_STATE.mem_stat)
+#define defer_head (OSALMEM_STATE.defer_head)
+#define hnd_table (OSALMEM_STATE.hnd_table)
+#define compact_pending (OSALMEM_STATE.compact_pending)
+#define blkMax (OSALMEM_STATE.blkMax)
+#define blkCnt (OSALMEM_STATE.blkCnt)
+#define blkFree (OSALMEM_STATE.blkFree)
+#define memAlo (OSALMEM_STATE.memAlo)
+#define memMax (OSALMEM_STATE.memMax)
+#define proCur (OSALMEM_STATE.proCur)
+#define proMax (OSALMEM_STATE.proMax)
+#define proTot (OSALMEM_STATE.proTot)
+#define proSmallBlkMiss (OSALMEM_STATE.proSmallBlkMiss)
+#define proSearchMax (OSALMEM_STATE.proSearchMax)
+#define trace_mute (OSALMEM_STATE.trace_mute)
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static osal_mem_hdr_t *osal_mem_search(uint16_t size);
+#if OSALMEM_PERSIST
+static bool osal_mem_reattach(void);
+#endif
+static void osal_mem_release(osal_mem_hdr_t *hdr);
+#if OSALMEM_DEFERRED_FREE
+static void osal_mem_drain_locked(void);
+#endif
+#if OSALMEM_TCACHE
+static osal_mem_hdr_t *osal_mem_tcache_get(uint16_t size);
+static bool osal_mem_tcache_put(osal_mem_hdr_t *hdr);
 #endif
 
 #ifdef DPRINTF_HEAPTRACE
@@ -157,8 +303,15 @@ void osal_mem_init(void) {
   OSAL_ASSERT(((OSALMEM_MIN_BLKSZ % OSALMEM_HDRSZ) == 0));
   OSAL_ASSERT(((OSALMEM_SMALL_BLKSZ % OSALMEM_HDRSZ) == 0));
 
+#if OSALMEM_PERSIST
+  // 上次运行的堆有效时直接恢复，不再格式化
+  if (osal_mem_reattach()) {
+    return;
+  }
+#endif
+
 #if OSALMEM_PROFILER
-  (void)osal_memset(theHeap, OSALMEM_INIT, MAXMEMHEAP);
+  (void)memset(theHeap, OSALMEM_INIT, MAXMEMHEAP);
 #endif
 
   // 最后一块内存的len设置为0，代表后面没有内存区域了
@@ -179,19 +332,175 @@ void osal_mem_init(void) {
   // Set 'len' & clear 'inUse' field.
   theHeap[OSALMEM_BIGBLK_IDX].val = OSALMEM_BIGBLK_SZ;
 
+#if OSALMEM_DEFERRED_FREE
+  atomic_store(&defer_head, OSALMEM_DEFER_NIL);
+#endif
+
 #if (OSALMEM_METRICS)
   /* Start with the small-block bucket and the wilderness - don't count the
    * end-of-heap NULL block nor the end-of-small-block NULL block.
    */
   blkCnt = blkFree = 2;
 #endif
+
+#if OSALMEM_PERSIST
+  // 堆格式化完成后最后写入魔数，格式化过程中重启会再次格式化
+  persist->version = OSALMEM_PERSIST_VERSION;
+  persist->heap_size = MAXMEMHEAP;
+  persist->base = (uintptr_t)persist;
+  memset(persist->root, 0, sizeof(persist->root));
+  persist->magic = OSALMEM_PERSIST_MAGIC;
+#endif
+}
+
+#if OSALMEM_PERSIST
+/**
+ * @brief 映射持久化区域，如果其中保存着有效的堆则恢复
+ * 恢复时释放所有未标记为持久保存的内存块，常驻内存需要重新申请。
+ * 逐块校验堆的结构，块长度无效、越界、分隔块或结束块不在原位置时认为堆已损坏，
+ * 例如拆分内存块时进程崩溃，清除魔数后重新格式化
+ *
+ * @return true 堆已恢复
+ * @return false 需要重新格式化堆
+ */
+static bool osal_mem_reattach(void) {
+  persist = hal_mem_persist_map(sizeof(struct osal_mem_persist) + MAXMEMHEAP);
+  OSAL_ASSERT(persist != NULL);
+  theHeap = (osal_mem_hdr_t *)(persist + 1);
+  mem_warm = false;
+
+  if ((persist->magic != OSALMEM_PERSIST_MAGIC) ||
+      (persist->version != OSALMEM_PERSIST_VERSION) ||
+      (persist->heap_size != MAXMEMHEAP) ||
+      (persist->base != (uintptr_t)persist)) {
+    persist->magic = 0;
+    return false;
+  }
+
+#if (OSALMEM_METRICS)
+  blkCnt = blkFree = memAlo = 0;
+#endif
+
+  osal_mem_hdr_t *const sep = theHeap + OSALMEM_SMALLBLK_HDRCNT;
+  osal_mem_hdr_t *const last = theHeap + OSALMEM_LASTBLK_IDX;
+  bool sep_seen = false;
+  osal_mem_hdr_t *hdr = theHeap;
+
+  for (; hdr < last; hdr = (osal_mem_hdr_t *)((uint8_t *)hdr + hdr->len)) {
+    // 块长度至少包含头部、按头部对齐，并且不能越过结束块
+    if ((hdr->len < OSALMEM_HDRSZ) || ((hdr->len % OSALMEM_HDRSZ) != 0) ||
+        (hdr->len > (size_t)((uint8_t *)last - (uint8_t *)hdr))) {
+      break;
+    }
+
+    // 两块区域中间的分隔块不统计
+    if (hdr == sep) {
+      if (!hdr->inUse || (hdr->len != OSALMEM_HDRSZ)) {
+        break;
+      }
+      sep_seen = true;
+      continue;
+    }
+
+    if (hdr->inUse && !hdr->persist) {
+      hdr->val = hdr->len; // Set 'len' & clear 'inUse' field.
+    }
+
+#if (OSALMEM_METRICS)
+    blkCnt++;
+    if (hdr->inUse) {
+      memAlo += hdr->len;
+    } else {
+      blkFree++;
+    }
+#endif
+  }
+
+  // 必须恰好走到结束块，并且经过了分隔块
+  if ((hdr != last) || !sep_seen || (last->val != 0)) {
+    persist->magic = 0;
+#if (OSALMEM_METRICS)
+    blkCnt = blkFree = memAlo = 0;
+#endif
+    return false;
+  }
+
+  // 相邻的空闲块在下一次申请时会被合并
+  ff1 = theHeap;
+  mem_warm = true;
+  return true;
+}
+
+/**
+ * @brief 将内存块标记为持久保存，重启后恢复堆时会保留该内存块
+ *
+ * @param ptr 通过osal_mem_alloc申请到的内存地址
+ */
+void osal_mem_persist(void *ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+
+  hal_reg_t intState = hal_enter_critical();
+  ((osal_mem_hdr_t *)ptr - 1)->persist = TRUE;
+  hal_exit_critical(intState);
+}
+
+/**
+ * @brief 设置根指针，指向的内存块会被标记为持久保存
+ *
+ * @param idx 根指针索引
+ * @param ptr 通过osal_mem_alloc申请到的内存地址，NULL表示清除
+ * @param version 数据版本，数据结构变化时需要修改版本
+ */
+void osal_mem_set_root(uint8_t idx, void *ptr, uint32_t version) {
+  if (idx >= OSALMEM_PERSIST_ROOTS) {
+    return;
+  }
+
+  osal_mem_persist(ptr);
+
+  hal_reg_t intState = hal_enter_critical();
+  persist->root[idx].off =
+      ptr ? (uint32_t)((uint8_t *)ptr - (uint8_t *)theHeap) : 0;
+  persist->root[idx].version = version;
+  hal_exit_critical(intState);
+}
+
+/**
+ * @brief 获取上次运行保存的根指针
+ *
+ * @param idx 根指针索引
+ * @param version 期望的数据版本
+ * @return void* 版本一致时返回内存地址，否则返回NULL
+ */
+void *osal_mem_get_root(uint8_t idx, uint32_t version) {
+  if ((idx >= OSALMEM_PERSIST_ROOTS) || (persist->root[idx].off == 0) ||
+      (persist->root[idx].version != version)) {
+    return NULL;
+  }
+  return (uint8_t *)theHeap + persist->root[idx].off;
 }
 
+/**
+ * @brief 堆是否是从上次运行中恢复的
+ *
+ * @return true 已恢复，可以通过osal_mem_get_root获取上次保存的数据
+ * @return false 堆是新格式化的
+ */
+bool osal_mem_is_warm(void) { return mem_warm; }
+#endif
+
 /*
  * 设置ff1指针跳过常驻内存区域，指向可申请区域的地址，加快后续的内存申请效率
  * 当系统任务都创建和初始化完成后调用此函数
  */
 void osal_mem_kick(void) {
+#if OSALMEM_TRACE
+  OSALMEM_TRACE_PRINTF("osalmem K\n");
+  trace_mute = 1;
+#endif
+
   osal_mem_hdr_t *tmp = osal_mem_alloc(1);
   OSAL_ASSERT((tmp != NULL));
   hal_reg_t cpu_sr = hal_enter_critical();
@@ -205,41 +514,25 @@ void osal_mem_kick(void) {
   // Set 'mem_stat' after the free because it enables memory profiling.
   mem_stat = 0x01;
   hal_exit_critical(cpu_sr);
+
+#if OSALMEM_TRACE
+  trace_mute = 0;
+#endif
 }
 
 /**
- * @brief 申请内存
+ * @brief 在堆中查找并分配一个内存块，调用者需处于临界区
  *
- * @param size 期望申请的内存大小Byte
- * @return void* 成功返回申请到的内存地址，失败返回NULL
+ * @param size 内存块大小（包括头部），已按字对齐
+ * @return osal_mem_hdr_t* 成功返回内存块头，失败返回NULL
  */
-#if DPRINTF_OSALHEAPTRACE
-void *osal_mem_alloc_dbg(uint16_t size, const char *fname, unsigned lnum)
-#else  /* DPRINTF_OSALHEAPTRACE */
-void *osal_mem_alloc(uint16_t size)
-#endif /* DPRINTF_OSALHEAPTRACE */
-{
+static osal_mem_hdr_t *osal_mem_search(uint16_t size) {
   osal_mem_hdr_t *prev = NULL;
   osal_mem_hdr_t *hdr;
-  hal_reg_t intState;
   uint8_t coal = 0;
-
-  size += OSALMEM_HDRSZ;
-
-  // size字对齐
-  // Calculate required bytes to add to 'size' to align to halDataAlign_t.
-  if (sizeof(halDataAlign_t) == 2) {
-    size += (size & 0x01);
-  } else if (sizeof(halDataAlign_t) != 1) {
-    const uint8_t mod = size % sizeof(halDataAlign_t);
-
-    if (mod != 0) {
-      size += (sizeof(halDataAlign_t) - mod);
-    }
-  }
-
-  // HAL_ENTER_CRITICAL_SECTION(intState); // Hold off interrupts.
-  intState = hal_enter_critical();
+#if OSALMEM_PROFILER
+  uint16_t walk = 0;
+#endif
 
   // 初始化阶段只在固定区域进行分配，这些内存就是常驻内存了
   // 初始化完成后，如果申请的size小于OSALMEM_SMALL_BLKSZ，则直接从固定区域分配，否则从非固定区域分配
@@ -257,6 +550,10 @@ void *osal_mem_alloc(uint16_t size)
   // 2.1、如果下一个区域也没被占用，则把两个区域合并起来，再次判断大小是否OK，如果OK跳出循环，如果不OK，HDR继续跳到下一个区域
   // 2.2、如果下一个区域被占用，则跳转到下一个区域
   do {
+#if OSALMEM_PROFILER
+    walk++;
+#endif
+
     if (hdr->inUse) {
       coal = 0;
     } else {
@@ -290,6 +587,13 @@ void *osal_mem_alloc(uint16_t size)
     }
   } while (1);
 
+#if OSALMEM_PROFILER
+  // 记录最坏情况下的查找长度，用于评估小块内存区域参数
+  if ((mem_stat != 0) && (proSearchMax < walk)) {
+    proSearchMax = walk;
+  }
+#endif
+
   // 如果找到了合适的区域，看看要不要进行拆分
   // 当区域的大小超过size+OSALMEM_MIN_BLKSZ，则进行拆分
   // 否则不进行拆分了
@@ -312,7 +616,7 @@ void *osal_mem_alloc(uint16_t size)
 #endif
     } else {
 #if (OSALMEM_METRICS)
-      memAlo += hdr->hdr.len;
+      memAlo += hdr->len;
       blkFree--;
 #endif
 
@@ -333,7 +637,7 @@ void *osal_mem_alloc(uint16_t size)
       uint8_t idx;
 
       for (idx = 0; idx < OSALMEM_PROMAX; idx++) {
-        if (hdr->hdr.len <= proCnt[idx]) {
+        if (hdr->len <= proCnt[idx]) {
           break;
         }
       }
@@ -352,38 +656,331 @@ void *osal_mem_alloc(uint16_t size)
        * rate during steady state Tx load, 0% during idle and steady state Rx
        * load.
        */
-      if ((hdr->hdr.len <= OSALMEM_SMALL_BLKSZ) &&
+      if ((hdr->len <= OSALMEM_SMALL_BLKSZ) &&
           (hdr >= (theHeap + OSALMEM_BIGBLK_IDX))) {
         proSmallBlkMiss++;
       }
     }
 
-    (void)osal_memset((uint8_t *)(hdr + 1), OSALMEM_ALOC,
-                      (hdr->hdr.len - OSALMEM_HDRSZ));
+    (void)memset((uint8_t *)(hdr + 1), OSALMEM_ALOC,
+                 (hdr->len - OSALMEM_HDRSZ));
 #endif
 
     // 如果分配的区域是最开始的块，移动ff1，提高下次分配的效率
     if ((mem_stat != 0) && (ff1 == hdr)) {
       ff1 = (osal_mem_hdr_t *)((uint8_t *)hdr + hdr->len);
     }
+  }
+
+  return hdr;
+}
+
+/**
+ * @brief 申请内存
+ *
+ * @param size 期望申请的内存大小Byte
+ * @return void* 成功返回申请到的内存地址，失败返回NULL
+ */
+#if DPRINTF_OSALHEAPTRACE
+void *osal_mem_alloc_dbg(uint16_t size, const char *fname, unsigned lnum)
+#else  /* DPRINTF_OSALHEAPTRACE */
+void *osal_mem_alloc(uint16_t size)
+#endif /* DPRINTF_OSALHEAPTRACE */
+{
+  osal_mem_hdr_t *hdr;
+  hal_reg_t intState;
+#if OSALMEM_TRACE
+  const uint16_t req = size;
+#endif
+
+  // 加上内存块头和对齐填充后会超出uint16_t
+  if (size > OSALMEM_ALLOC_MAX) {
+    return NULL;
+  }
+
+#if OSALMEM_DEFERRED_FREE
+  // 数据区至少要能放下延迟释放链表的链接字段
+  if (size < sizeof(uint32_t)) {
+    size = sizeof(uint32_t);
+  }
+#endif
+
+  size += OSALMEM_HDRSZ;
+
+  // size字对齐
+  // Calculate required bytes to add to 'size' to align to halDataAlign_t.
+  if (sizeof(halDataAlign_t) == 2) {
+    size += (size & 0x01);
+  } else if (sizeof(halDataAlign_t) != 1) {
+    const uint8_t mod = size % sizeof(halDataAlign_t);
+
+    if (mod != 0) {
+      size += (sizeof(halDataAlign_t) - mod);
+    }
+  }
+
+#if OSALMEM_TCACHE
+  // 线程缓存命中时无需进入临界区
+  hdr = osal_mem_tcache_get(size);
+  if (hdr == NULL)
+#endif
+  {
+    // HAL_ENTER_CRITICAL_SECTION(intState); // Hold off interrupts.
+    intState = hal_enter_critical();
+
+#if OSALMEM_DEFERRED_FREE
+    // 先批量回收其他线程或中断延迟释放的内存
+    osal_mem_drain_locked();
+#endif
+
+    hdr = osal_mem_search(size);
 
+    // HAL_EXIT_CRITICAL_SECTION(intState); // Re-enable interrupts.
+    hal_exit_critical(intState);
+  }
+
+  if (hdr != NULL) {
     // 返回给调用者的是把头部去掉后的真正可用的区域
     hdr++;
   }
 
-  // HAL_EXIT_CRITICAL_SECTION(intState); // Re-enable interrupts.
-  hal_exit_critical(intState);
-
   OSAL_ASSERT(((size_t)hdr % sizeof(halDataAlign_t)) == 0);
 
+#if OSALMEM_TRACE
+  if (!trace_mute) {
+    OSALMEM_TRACE_PRINTF("osalmem A %u %u\n", req,
+                         hdr ? OSALMEM_TRACE_OFFSET(hdr) : 0);
+  }
+#endif
+
 #if DPRINTF_OSALHEAPTRACE
   dprintf("osal_mem_alloc(%u)->%lx:%s:%u\n", size, (unsigned)hdr, fname, lnum);
 #endif /* DPRINTF_OSALHEAPTRACE */
   return (void *)hdr;
 }
 
+#if OSALMEM_HANDLE
+/**
+ * @brief 判断释放的内存块之后是否有未锁定的可移动内存块，有才需要整理
+ * 只查找句柄表，不遍历堆，调用者需处于临界区
+ *
+ * @param hdr 释放的内存块头
+ * @return true 需要整理
+ */
+static bool osal_mem_compact_needed(const osal_mem_hdr_t *hdr) {
+  for (uint8_t id = 0; id < OSALMEM_HANDLE_MAX; id++) {
+    const osal_mem_hdr_t *blk = hnd_table[id].hdr;
+    if ((blk > hdr) && blk->movable && (hnd_table[id].lock == 0)) {
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+/**
+ * @brief 将内存块归还给堆，调用者需处于临界区
+ *
+ * @param hdr 内存块头
+ */
+static void osal_mem_release(osal_mem_hdr_t *hdr) {
+  hdr->inUse = FALSE;
+#if OSALMEM_DEFERRED_FREE
+  hdr->deferred = FALSE;
+#endif
+#if OSALMEM_PERSIST
+  hdr->persist = FALSE;
+#endif
+
+#if OSALMEM_HANDLE
+  if ((hdr >= (theHeap + OSALMEM_BIGBLK_IDX)) && osal_mem_compact_needed(hdr)) {
+    compact_pending = true;
+  }
+#endif
+
+  // 释放的区域在ff1前面，移动ff1
+  if (ff1 > hdr) {
+    ff1 = hdr;
+  }
+
+#if OSALMEM_PROFILER
+#if !OSALMEM_PROFILER_LL
+  if (mem_stat != 0) // Don't profile until after the LL block is filled.
+#endif
+  {
+    uint8_t idx;
+
+    for (idx = 0; idx < OSALMEM_PROMAX; idx++) {
+      if (hdr->len <= proCnt[idx]) {
+        break;
+      }
+    }
+
+    proCur[idx]--;
+  }
+
+  (void)memset((uint8_t *)(hdr + 1), OSALMEM_REIN, (hdr->len - OSALMEM_HDRSZ));
+#endif
+#if OSALMEM_METRICS
+  memAlo -= hdr->len;
+  blkFree++;
+#endif
+}
+
+#if OSALMEM_DEFERRED_FREE
+/**
+ * @brief 将内存块压入延迟释放栈，只有一次原子操作，不进入临界区
+ * 栈只会被osal_mem_drain_locked整体取走，不存在单个弹出，因此没有ABA问题
+ * 压栈前先原子地置位deferred，重复释放同一块时不会再次压栈，避免栈中出现环
+ *
+ * @param hdr 内存块头
+ */
+static void osal_mem_defer(osal_mem_hdr_t *hdr) {
+  uint32_t idx = (uint32_t)(hdr - theHeap);
+  uint32_t old = atomic_fetch_or_explicit((_Atomic uint32_t *)&hdr->val,
+                                          OSALMEM_DEFERRED,
+                                          memory_order_relaxed);
+
+  // 重复释放
+  HAL_ASSERT(!(old & OSALMEM_DEFERRED));
+  if (old & OSALMEM_DEFERRED) {
+    return;
+  }
+
+  uint32_t head = atomic_load_explicit(&defer_head, memory_order_relaxed);
+
+  do {
+    OSALMEM_DEFER_LINK(hdr) = head;
+  } while (!atomic_compare_exchange_weak_explicit(
+      &defer_head, &head, idx, memory_order_release, memory_order_relaxed));
+}
+
+/**
+ * @brief 一次取走整个延迟释放栈并批量归还给堆，调用者需处于临界区
+ *
+ */
+static void osal_mem_drain_locked(void) {
+  uint32_t idx = atomic_exchange_explicit(&defer_head, OSALMEM_DEFER_NIL,
+                                          memory_order_acquire);
+
+  while (idx != OSALMEM_DEFER_NIL) {
+    osal_mem_hdr_t *hdr = theHeap + idx;
+    idx = OSALMEM_DEFER_LINK(hdr);
+    osal_mem_release(hdr);
+  }
+}
+
+/**
+ * @brief 批量回收延迟释放的内存，可在空闲循环中调用
+ *
+ */
+void osal_mem_drain(void) {
+  if (atomic_load_explicit(&defer_head, memory_order_relaxed) ==
+      OSALMEM_DEFER_NIL) {
+    return;
+  }
+
+  hal_reg_t intState = hal_enter_critical();
+  osal_mem_drain_locked();
+  hal_exit_critical(intState);
+}
+#endif
+
+#if OSALMEM_TCACHE
+/**
+ * @brief 从线程缓存中取一个内存块，缓存为空时一次临界区内批量补充
+ * 常驻内存阶段不使用缓存，保证常驻内存仍然分配在常驻区域
+ *
+ * @param size 内存块大小（包括头部），已按字对齐
+ * @return osal_mem_hdr_t* 成功返回内存块头，失败返回NULL
+ */
+static osal_mem_hdr_t *osal_mem_tcache_get(uint16_t size) {
+  // 向上取整，保证该档位中的块都不小于size
+  size = OSALMEM_ROUND(size);
+  if ((mem_stat == 0) || (size > OSALMEM_TCACHE_MAXSZ)) {
+    return NULL;
+  }
+
+  const uint8_t bin = (size / OSALMEM_HDRSZ) - 1;
+
+  if (tcache.cnt[bin] == 0) {
+    hal_reg_t intState = hal_enter_critical();
+
+#if OSALMEM_DEFERRED_FREE
+    osal_mem_drain_locked();
+#endif
+
+    while (tcache.cnt[bin] < OSALMEM_TCACHE_BATCH) {
+      osal_mem_hdr_t *hdr = osal_mem_search(size);
+      if (hdr == NULL) {
+        break;
+      }
+      tcache.blk[bin][tcache.cnt[bin]++] = hdr;
+    }
+
+    hal_exit_critical(intState);
+
+    if (tcache.cnt[bin] == 0) {
+      return NULL;
+    }
+  }
+
+  return tcache.blk[bin][--tcache.cnt[bin]];
+}
+
+/**
+ * @brief 将内存块放入线程缓存，缓存已满时一次临界区内批量归还一半给堆
+ *
+ * @param hdr 内存块头
+ * @return true 已放入缓存
+ * @return false 不适合放入缓存，需要直接归还给堆
+ */
+static bool osal_mem_tcache_put(osal_mem_hdr_t *hdr) {
+  if ((mem_stat == 0) || (hdr->len > OSALMEM_TCACHE_MAXSZ)) {
+    return false;
+  }
+
+#if OSALMEM_PERSIST
+  // 持久保存的内存块直接归还给堆，由osal_mem_release清除标记
+  if (hdr->persist) {
+    return false;
+  }
+#endif
+
+  // 向下取整，保证该档位中的块都不小于档位大小
+  const uint8_t bin = (hdr->len / OSALMEM_HDRSZ) - 1;
+
+  if (tcache.cnt[bin] >= OSALMEM_TCACHE_CNT) {
+    hal_reg_t intState = hal_enter_critical();
+    for (uint8_t i = 0; i < OSALMEM_TCACHE_BATCH; i++) {
+      osal_mem_release(tcache.blk[bin][--tcache.cnt[bin]]);
+    }
+    hal_exit_critical(intState);
+  }
+
+  tcache.blk[bin][tcache.cnt[bin]++] = hdr;
+  return true;
+}
+
+/**
+ * @brief 将当前线程缓存的内存块全部归还给堆，线程退出前需要调用
+ *
+ */
+void osal_mem_tcache_flush(void) {
+  hal_reg_t intState = hal_enter_critical();
+  for (uint8_t bin = 0; bin < OSALMEM_TCACHE_BINS; bin++) {
+    while (tcache.cnt[bin] > 0) {
+      osal_mem_release(tcache.blk[bin][--tcache.cnt[bin]]);
+    }
+  }
+  hal_exit_critical(intState);
+}
+#endif
+
 /*
  * Free a block of memory.
+ * 开启OSALMEM_DEFERRED_FREE时，内存块只是被压入延迟释放栈，
+ * 在下一次申请内存或osal_mem_drain时才真正归还给堆
  */
 #if DPRINTF_OSALHEAPTRACE
 void osal_mem_free_dbg(void *ptr, const char *fname, unsigned lnum)
@@ -392,7 +989,6 @@ void osal_mem_free(void *ptr)
 #endif /* DPRINTF_OSALHEAPTRACE */
 {
   osal_mem_hdr_t *hdr = (osal_mem_hdr_t *)ptr - 1;
-  hal_reg_t intState;
 
 #if DPRINTF_OSALHEAPTRACE
   dprintf("osal_mem_free(%lx):%s:%u\n", (unsigned)ptr, fname, lnum);
@@ -402,42 +998,208 @@ void osal_mem_free(void *ptr)
              ((uint8_t *)ptr < (uint8_t *)theHeap + MAXMEMHEAP));
   HAL_ASSERT(hdr->inUse);
 
-  // HAL_ENTER_CRITICAL_SECTION(intState); // Hold off interrupts.
-  intState = hal_enter_critical();
-  hdr->inUse = FALSE;
+#if OSALMEM_TRACE
+  if (!trace_mute) {
+    OSALMEM_TRACE_PRINTF("osalmem F %u\n", OSALMEM_TRACE_OFFSET(ptr));
+  }
+#endif
 
-  // 释放的区域在ff1前面，移动ff1
-  if (ff1 > hdr) {
-    ff1 = hdr;
+#if OSALMEM_TCACHE
+  // 放入线程缓存成功则无需进入临界区
+  if (osal_mem_tcache_put(hdr)) {
+    return;
   }
+#endif
 
-#if OSALMEM_PROFILER
-#if !OSALMEM_PROFILER_LL
-  if (mem_stat != 0) // Don't profile until after the LL block is filled.
+#if OSALMEM_DEFERRED_FREE
+  osal_mem_defer(hdr);
+#else
+  // HAL_ENTER_CRITICAL_SECTION(intState); // Hold off interrupts.
+  hal_reg_t intState = hal_enter_critical();
+
+  osal_mem_release(hdr);
+
+  // HAL_EXIT_CRITICAL_SECTION(intState); // Re-enable interrupts.
+  hal_exit_critical(intState);
 #endif
-  {
-    uint8_t idx;
+}
 
-    for (idx = 0; idx < OSALMEM_PROMAX; idx++) {
-      if (hdr->hdr.len <= proCnt[idx]) {
-        break;
-      }
+#if OSALMEM_HANDLE
+/**
+ * @brief 通过句柄申请可移动的内存，访问前需要调用osal_mem_lock获取地址
+ * 申请长度至少按小块内存的大小计算，保证内存块分配在可以整理的大块区域；
+ * osal_mem_kick之前申请的句柄内存是常驻内存，可能位于小块区域，不会被移动
+ *
+ * @param size 期望申请的内存大小Byte
+ * @return osal_mem_handle_t 成功返回句柄，失败返回OSALMEM_INVALID_HANDLE
+ */
+osal_mem_handle_t osal_mem_halloc(uint16_t size) {
+  uint16_t req = size + OSALMEM_HDRSZ;
+  if (req < OSALMEM_SMALL_BLKSZ) {
+    req = OSALMEM_SMALL_BLKSZ;
+  }
+
+  void *ptr = osal_mem_alloc(req);
+  if (ptr == NULL) {
+    return OSALMEM_INVALID_HANDLE;
+  }
+
+  osal_mem_hdr_t *hdr = (osal_mem_hdr_t *)ptr - 1;
+  uint8_t id;
+
+  hal_reg_t intState = hal_enter_critical();
+  for (id = 0; id < OSALMEM_HANDLE_MAX; id++) {
+    if (hnd_table[id].hdr == NULL) {
+      hnd_table[id].hdr = hdr;
+      hnd_table[id].lock = 0;
+      OSALMEM_HANDLE_ID(hdr) = id;
+      // 只有大块区域中的内存块才会被整理
+      hdr->movable = (hdr >= (theHeap + OSALMEM_BIGBLK_IDX));
+      break;
     }
+  }
+  hal_exit_critical(intState);
 
-    proCur[idx]--;
+  // 句柄表已满
+  if (id >= OSALMEM_HANDLE_MAX) {
+    osal_mem_free(ptr);
+    return OSALMEM_INVALID_HANDLE;
+  }
+  return (osal_mem_handle_t)(id + 1);
+}
+
+/**
+ * @brief 释放通过句柄申请的内存
+ *
+ * @param handle 句柄
+ */
+void osal_mem_hfree(osal_mem_handle_t handle) {
+  if (handle == OSALMEM_INVALID_HANDLE || handle > OSALMEM_HANDLE_MAX) {
+    return;
   }
 
-  (void)osal_memset((uint8_t *)(hdr + 1), OSALMEM_REIN,
-                    (hdr->hdr.len - OSALMEM_HDRSZ));
+  hal_reg_t intState = hal_enter_critical();
+  osal_mem_hdr_t *hdr = hnd_table[handle - 1].hdr;
+  hnd_table[handle - 1].hdr = NULL;
+  if (hdr != NULL) {
+    // 延迟释放或线程缓存中的内存块不能再被移动
+    hdr->movable = FALSE;
+  }
+  hal_exit_critical(intState);
+
+  if (hdr != NULL) {
+    osal_mem_free(hdr + 1);
+  }
+}
+
+/**
+ * @brief 锁定句柄并获取内存地址，锁定期间内存块不会被移动，可以嵌套调用，最多嵌套255层
+ *
+ * @param handle 句柄
+ * @return void* 成功返回内存地址，失败返回NULL
+ */
+void *osal_mem_lock(osal_mem_handle_t handle) {
+  void *ptr = NULL;
+
+  if (handle == OSALMEM_INVALID_HANDLE || handle > OSALMEM_HANDLE_MAX) {
+    return NULL;
+  }
+
+  hal_reg_t intState = hal_enter_critical();
+  struct osal_mem_handle *entry = &hnd_table[handle - 1];
+  // 锁定计数溢出
+  HAL_ASSERT(entry->lock < UINT8_MAX);
+  if ((entry->hdr != NULL) && (entry->lock < UINT8_MAX)) {
+    entry->lock++;
+    ptr = OSALMEM_HANDLE_PTR(entry->hdr);
+  }
+  hal_exit_critical(intState);
+
+  return ptr;
+}
+
+/**
+ * @brief 解锁句柄，解锁后之前获取的内存地址不再有效
+ *
+ * @param handle 句柄
+ */
+void osal_mem_unlock(osal_mem_handle_t handle) {
+  if (handle == OSALMEM_INVALID_HANDLE || handle > OSALMEM_HANDLE_MAX) {
+    return;
+  }
+
+  hal_reg_t intState = hal_enter_critical();
+  struct osal_mem_handle *entry = &hnd_table[handle - 1];
+  if (entry->hdr != NULL && entry->lock > 0) {
+    entry->lock--;
+    if ((entry->lock == 0) && entry->hdr->movable) {
+      compact_pending = true;
+    }
+  }
+  hal_exit_critical(intState);
+}
+
+/**
+ * @brief 整理大块内存区域，将未锁定的句柄内存块向前滑动，合并出连续的空闲空间
+ * 整理过程在一个临界区内完成，应在空闲时调用，没有需要整理的内容时直接返回
+ *
+ */
+void osal_mem_compact(void) {
+  if (!compact_pending) {
+    return;
+  }
+
+  hal_reg_t intState = hal_enter_critical();
+
+#if OSALMEM_DEFERRED_FREE
+  osal_mem_drain_locked();
 #endif
-#if OSALMEM_METRICS
-  memAlo -= hdr->hdr.len;
-  blkFree++;
+
+  compact_pending = false;
+
+  osal_mem_hdr_t *hdr = theHeap + OSALMEM_BIGBLK_IDX;
+  osal_mem_hdr_t *gap = NULL; // 当前空闲区域的起始位置
+  uint32_t gap_len = 0;       // 当前空闲区域的长度
+
+  while (hdr->val != 0) {
+    // 移动之前先记下下一个块，移动只会覆盖当前块及其之前的区域
+    osal_mem_hdr_t *next = (osal_mem_hdr_t *)((uint8_t *)hdr + hdr->len);
+
+    if (!hdr->inUse) {
+      // 空闲块并入当前空闲区域
+      if (gap == NULL) {
+        gap = hdr;
+        gap_len = 0;
+      } else {
+#if (OSALMEM_METRICS)
+        blkCnt--;
+        blkFree--;
 #endif
+      }
+      gap_len += hdr->len;
+    } else if ((gap != NULL) && hdr->movable &&
+               (hnd_table[OSALMEM_HANDLE_ID(hdr)].lock == 0)) {
+      // 可移动的块滑动到空闲区域的起始位置，空闲区域随之后移
+      const uint32_t len = hdr->len;
+      memmove(gap, hdr, len);
+      hnd_table[OSALMEM_HANDLE_ID(gap)].hdr = gap;
+      gap = (osal_mem_hdr_t *)((uint8_t *)gap + len);
+    } else if (gap != NULL) {
+      // 遇到不能移动的块，结束当前空闲区域
+      gap->val = gap_len; // Set 'len' & clear 'inUse' field.
+      gap = NULL;
+    }
+
+    hdr = next;
+  }
+
+  if (gap != NULL) {
+    gap->val = gap_len;
+  }
 
-  // HAL_EXIT_CRITICAL_SECTION(intState); // Re-enable interrupts.
   hal_exit_critical(intState);
 }
+#endif
 
 #if OSALMEM_METRICS
 /*********************************************************************
@@ -37,6 +37,73 @@ extern "C" {
 #define OSALMEM_PROFILER_LL 0
 #endif
 
+// 使能内存申请释放记录功能，每次申请、释放输出一行记录，
+// 记录可用tools/osal_mem_tune离线回放，评估小块内存区域的参数
+#ifndef OSALMEM_TRACE
+#define OSALMEM_TRACE 0
+#endif
+
+// 使能延迟释放功能，osal_mem_free只做一次原子压栈，可在中断或其他线程中调用
+// 被释放的内存在下一次申请内存或调用osal_mem_drain时批量归还
+#ifndef OSALMEM_DEFERRED_FREE
+#define OSALMEM_DEFERRED_FREE 0
+#endif
+
+// 使能线程缓存功能，每个线程缓存最近释放的小内存块，多线程申请内存时减少临界区竞争
+// 需要编译器支持_Thread_local，不能在中断中申请或释放内存
+#ifndef OSALMEM_TCACHE
+#define OSALMEM_TCACHE 0
+#endif
+
+// 线程缓存的最大内存块大小（包括头部）
+#ifndef OSALMEM_TCACHE_MAXSZ
+#define OSALMEM_TCACHE_MAXSZ 64
+#endif
+
+// 线程缓存每个档位最多缓存的内存块数量
+#ifndef OSALMEM_TCACHE_CNT
+#define OSALMEM_TCACHE_CNT 8
+#endif
+
+// 线程缓存每次从堆中补充或归还的内存块数量
+#ifndef OSALMEM_TCACHE_BATCH
+#define OSALMEM_TCACHE_BATCH (OSALMEM_TCACHE_CNT / 2)
+#endif
+
+// 使能句柄内存功能，通过句柄申请的内存可以在空闲时被整理移动，减少内存碎片
+#ifndef OSALMEM_HANDLE
+#define OSALMEM_HANDLE 0
+#endif
+
+// 句柄表大小，即同时存在的句柄内存块的最大数量
+#ifndef OSALMEM_HANDLE_MAX
+#define OSALMEM_HANDLE_MAX 16
+#endif
+
+#if OSALMEM_HANDLE
+// 内存句柄
+typedef uint8_t osal_mem_handle_t;
+
+// 无效句柄
+#define OSALMEM_INVALID_HANDLE 0
+#endif
+
+// 使能持久化堆功能，堆放在hal_mem_persist_map映射的区域中，
+// 程序重启后可以通过根指针恢复上次运行中标记为持久保存的数据
+#ifndef OSALMEM_PERSIST
+#define OSALMEM_PERSIST 0
+#endif
+
+// 持久化堆的格式版本，修改堆参数或持久数据布局后需要增加版本，使旧数据失效
+#ifndef OSALMEM_PERSIST_VERSION
+#define OSALMEM_PERSIST_VERSION 1
+#endif
+
+// 持久化根指针数量
+#ifndef OSALMEM_PERSIST_ROOTS
+#define OSALMEM_PERSIST_ROOTS 8
+#endif
+
 /*
  * 初始化内存管理器
  */
@@ -49,10 +116,14 @@ void osal_mem_init(void);
 void osal_mem_kick(void);
 
 
+// osal_mem_alloc单次最多申请的字节数，加上4字节内存块头和对齐填充后不能超过uint16_t
+#define OSALMEM_ALLOC_MAX                                                      \
+  (UINT16_MAX - sizeof(uint32_t) - (sizeof(halDataAlign_t) - 1))
+
 /**
  * @brief 申请内存
  * 
- * @param size 期望申请的内存大小Byte
+ * @param size 期望申请的内存大小Byte，不能超过OSALMEM_ALLOC_MAX
  * @return void* 成功返回申请到的内存地址，失败返回NULL
  */
 #if DPRINTF_OSALHEAPTRACE
@@ -74,6 +145,98 @@ void osal_mem_free_dbg(void *ptr, const char *fname, unsigned lnum);
 void osal_mem_free(void *ptr);
 #endif
 
+#if OSALMEM_DEFERRED_FREE
+/**
+ * @brief 批量回收延迟释放的内存，osal_run在每次调度后会自动调用
+ *
+ */
+void osal_mem_drain(void);
+#endif
+
+#if OSALMEM_TCACHE
+/**
+ * @brief 将当前线程缓存的内存块全部归还给堆，线程退出前需要调用
+ *
+ */
+void osal_mem_tcache_flush(void);
+#endif
+
+#if OSALMEM_HANDLE
+/**
+ * @brief 通过句柄申请可移动的内存，访问前需要调用osal_mem_lock获取地址
+ * 小于OSALMEM_SMALL_BLKSZ的申请也分配在大块区域；
+ * osal_mem_kick之前申请的句柄内存是常驻内存，不会被移动
+ *
+ * @param size 期望申请的内存大小Byte
+ * @return osal_mem_handle_t 成功返回句柄，失败返回OSALMEM_INVALID_HANDLE
+ */
+osal_mem_handle_t osal_mem_halloc(uint16_t size);
+
+/**
+ * @brief 释放通过句柄申请的内存
+ *
+ * @param handle 句柄
+ */
+void osal_mem_hfree(osal_mem_handle_t handle);
+
+/**
+ * @brief 锁定句柄并获取内存地址，锁定期间内存块不会被移动，可以嵌套调用，最多嵌套255层
+ *
+ * @param handle 句柄
+ * @return void* 成功返回内存地址，失败返回NULL
+ */
+void *osal_mem_lock(osal_mem_handle_t handle);
+
+/**
+ * @brief 解锁句柄，解锁后之前获取的内存地址不再有效
+ *
+ * @param handle 句柄
+ */
+void osal_mem_unlock(osal_mem_handle_t handle);
+
+/**
+ * @brief 整理大块内存区域，合并出连续的空闲空间，没有任务就绪时会自动调用
+ *
+ */
+void osal_mem_compact(void);
+#endif
+
+#if OSALMEM_PERSIST
+/**
+ * @brief 将内存块标记为持久保存，重启后恢复堆时会保留该内存块
+ * 持久数据中的指针只有在区域映射到相同地址时才有效，不能保存函数指针
+ *
+ * @param ptr 通过osal_mem_alloc申请到的内存地址
+ */
+void osal_mem_persist(void *ptr);
+
+/**
+ * @brief 设置根指针，指向的内存块会被标记为持久保存
+ *
+ * @param idx 根指针索引
+ * @param ptr 通过osal_mem_alloc申请到的内存地址，NULL表示清除
+ * @param version 数据版本，数据结构变化时需要修改版本
+ */
+void osal_mem_set_root(uint8_t idx, void *ptr, uint32_t version);
+
+/**
+ * @brief 获取上次运行保存的根指针
+ *
+ * @param idx 根指针索引
+ * @param version 期望的数据版本
+ * @return void* 版本一致时返回内存地址，否则返回NULL
+ */
+void *osal_mem_get_root(uint8_t idx, uint32_t version);
+
+/**
+ * @brief 堆是否是从上次运行中恢复的
+ *
+ * @return true 已恢复，可以通过osal_mem_get_root获取上次保存的数据
+ * @return false 堆是新格式化的
+ */
+bool osal_mem_is_warm(void);
+#endif
+
 #if (OSALMEM_METRICS)
 /*
  * Return the maximum number of blocks ever allocated at once.
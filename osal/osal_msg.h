@@ -0,0 +1,313 @@
+/**
+ * @file osal_msg.h
+ * @author ljgabc
+ * @brief 任务间消息
+ * 每个任务有一个先进先出的消息队列，发送消息后会自动置位接收任务的OSAL_SYS_EVENT_MSG事件
+ * @version 0.1
+ * @date 2024-12-04
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "osal_config.h"
+#include "osal_task.h"
+#include "osal_types.h"
+
+// 使能无锁消息投递，其他线程只用原子操作就可以通过osal_msg_post和osal_event_post
+// 向任务投递消息和事件，osal在每次调度前批量取出。需要编译器支持C11原子操作
+#ifndef OSAL_MSG_MPSC
+#define OSAL_MSG_MPSC 0
+#endif
+
+// 每个任务消息队列的优先级通道数量，取值1~16，接收时总是先取出高优先级通道中的消息
+#ifndef OSAL_MSG_LANES
+#define OSAL_MSG_LANES 2
+#endif
+
+// 每个任务内嵌的小数据事件环形队列深度，为0时不使用此功能
+// 小数据事件的数据直接拷贝到任务控制块中，不需要申请和释放内存
+#ifndef OSAL_EVT_RING
+#define OSAL_EVT_RING 0
+#endif
+
+// 小数据事件最多携带的数据字节数
+#ifndef OSAL_EVT_DATA_MAX
+#define OSAL_EVT_DATA_MAX 8
+#endif
+
+struct osal_tcb;
+struct osal_msg_hdr;
+
+// 系统消息事件，任务消息队列非空时由osal置位，应用不能再使用此事件位，
+// 固定为事件的最高位，16位事件时为0x8000
+#define OSAL_SYS_EVENT_MSG ((osal_event_t)1 << (OSAL_EVENT_BITS - 1))
+
+// 系统小数据事件，开启OSAL_EVT_RING后任务的小数据事件队列非空时由osal置位，
+// 开启后应用不能再使用此事件位，16位事件时为0x4000
+#define OSAL_SYS_EVENT_DATA ((osal_event_t)1 << (OSAL_EVENT_BITS - 2))
+
+// 消息优先级通道
+#define OSAL_MSG_PRIO_NORMAL 0 // 普通消息，如业务数据
+#define OSAL_MSG_PRIO_URGENT 1 // 紧急消息，如控制、应答消息
+
+// 消息数据段，用于osal_send_msgv
+struct osal_iovec {
+  const void *base; // 数据段地址
+  uint16_t len;     // 数据段长度
+};
+
+// 消息队列已满时的处理策略
+#define OSAL_MSG_POLICY_REJECT 0      // 拒绝新消息，发送端可以稍后重发
+#define OSAL_MSG_POLICY_DROP_OLDEST 1 // 丢弃最旧的消息，放入新消息，丢弃旧消息也放不下时只丢弃新消息
+#define OSAL_MSG_POLICY_DROP_NEWEST 2 // 丢弃新消息
+
+/**
+ * @brief 申请消息缓冲区
+ *
+ * @param len 所需缓冲区长度，为0或加上消息头后超过OSALMEM_ALLOC_MAX时失败
+ * @return uint8_t* 指向已分配缓冲区的指针，如果分配失败，则返回 NULL
+ */
+uint8_t *osal_msg_allocate(uint16_t len);
+
+/**
+ * @brief 任务完成对收到的消息处理后，调用此函数释放缓冲区
+ *
+ * @param msg 消息缓冲区指针
+ */
+void osal_msg_deallocate(uint8_t *msg);
+
+/**
+ * @brief 获取消息长度
+ *
+ * @param msg 消息缓冲区指针
+ * @return uint16_t 消息长度
+ */
+uint16_t osal_msg_len(const uint8_t *msg);
+
+/**
+ * @brief 将消息放到任务的消息队列尾部，并置位任务的OSAL_SYS_EVENT_MSG事件
+ * 此函数会将buf中的数据拷贝到一个新消息缓冲区中，调用完此函数后buf可以被释放了。
+ * 新的消息缓冲区由消息消费端调用osal_msg_deallocate释放。
+ * 队列已满且不丢弃旧消息时不会申请缓冲区。
+ *
+ * @param task 任务指针
+ * @param buf 消息数据
+ * @param len 消息长度
+ * @return uint8_t 成功返回OSAL_OK，队列已满返回OSAL_MSG_QUEUE_FULL或OSAL_MSG_DROPPED，
+ * 长度为0返回OSAL_MSG_EMPTY，消息过长返回OSAL_MSG_TOO_LONG
+ */
+uint8_t osal_send_msg(struct osal_tcb *task, const uint8_t *buf, uint16_t len);
+
+/**
+ * @brief 将消息放到任务消息队列指定优先级通道的尾部，其他同osal_send_msg
+ * 接收任务总是先取出高优先级通道中的消息
+ *
+ * @param task 任务指针
+ * @param buf 消息数据
+ * @param len 消息长度
+ * @param prio 优先级通道，0~OSAL_MSG_LANES-1，越大越优先
+ * @return uint8_t 成功返回OSAL_OK，队列已满返回OSAL_MSG_QUEUE_FULL或OSAL_MSG_DROPPED
+ */
+uint8_t osal_send_msg_prio(struct osal_tcb *task, const uint8_t *buf,
+                           uint16_t len, uint8_t prio);
+
+/**
+ * @brief 将多个osal_msg_allocate申请的消息缓冲区按顺序放到任务的消息队列中，不拷贝数据
+ * 任务消息队列不限制容量时，所有消息在一个临界区中放入队列。
+ * 已放入队列或被丢弃的消息所有权转移给接收任务；队列已满时停止，
+ * 剩余的消息仍归发送端所有，可以从msgs[返回值]开始重发
+ *
+ * @param task 任务指针
+ * @param msgs 消息缓冲区指针数组
+ * @param cnt 消息数量
+ * @return uint16_t 所有权已转移的消息数量
+ */
+uint16_t osal_msg_send_batch(struct osal_tcb *task, uint8_t *const msgs[],
+                             uint16_t cnt);
+
+/**
+ * @brief 在一个临界区中取出任务消息队列中的全部消息，并清除OSAL_SYS_EVENT_MSG事件
+ * 消息按优先级从高到低、同一优先级按先后顺序排列，使用osal_msg_next逐条取出，
+ * 取出后的消息和osal_msg_receive得到的一样，需要调用osal_msg_deallocate释放
+ *
+ * @param task 任务指针
+ * @return struct osal_msg_hdr* 消息链，队列为空时返回NULL
+ */
+struct osal_msg_hdr *osal_msg_receive_all(struct osal_tcb *task);
+
+/**
+ * @brief 从osal_msg_receive_all得到的消息链中取出下一条消息，不进入临界区
+ *
+ * @param chain 消息链，取出后指向剩余的消息
+ * @return uint8_t* 消息缓冲区指针，消息链为空时返回NULL
+ */
+uint8_t *osal_msg_next(struct osal_msg_hdr **chain);
+
+/**
+ * @brief 设置消息的优先级通道，在osal_msg_send_owned、osal_publish等发送之前调用
+ * osal_msg_allocate申请的消息默认为OSAL_MSG_PRIO_NORMAL
+ *
+ * @param msg 消息缓冲区指针
+ * @param prio 优先级通道，超过OSAL_MSG_LANES-1时使用最高优先级通道
+ */
+void osal_msg_set_prio(uint8_t *msg, uint8_t prio);
+
+/**
+ * @brief 将多段数据依次拷贝到一个新消息缓冲区中，放到任务的消息队列尾部，其他同osal_send_msg
+ * 只申请一次缓冲区、拷贝一次数据，发送端不需要先拼接成连续的临时缓冲区
+ *
+ * @param task 任务指针
+ * @param iov 数据段数组
+ * @param cnt 数据段数量
+ * @return uint8_t 成功返回OSAL_OK，消息总长度超出消息缓冲区上限返回OSAL_MSG_TOO_LONG，
+ * 总长度为0返回OSAL_MSG_EMPTY
+ */
+uint8_t osal_send_msgv(struct osal_tcb *task, const struct osal_iovec *iov,
+                       uint8_t cnt);
+
+/**
+ * @brief 将osal_msg_allocate申请的消息缓冲区直接放到任务的消息队列尾部，不拷贝数据
+ * 调用后消息缓冲区的所有权转移给接收任务，发送端不能再访问或释放该缓冲区。
+ * 任务无效时缓冲区会被释放；返回OSAL_MSG_QUEUE_FULL时缓冲区仍归发送端所有，可以稍后重发
+ *
+ * @param task 任务指针
+ * @param msg 消息缓冲区指针
+ * @return uint8_t 成功返回OSAL_OK
+ */
+uint8_t osal_msg_send_owned(struct osal_tcb *task, uint8_t *msg);
+
+/**
+ * @brief 与osal_msg_send_owned相同，但不论任务的队列处理策略如何，新消息都不会被丢弃：
+ * 放不下时返回OSAL_MSG_QUEUE_FULL，缓冲区仍归发送端所有；放入队列后也不会因为之后
+ * 发送的消息按OSAL_MSG_POLICY_DROP_OLDEST被丢弃，用于RPC请求等必须确认送达的消息
+ *
+ * @param task 任务指针
+ * @param msg 消息缓冲区指针
+ * @return uint8_t 成功返回OSAL_OK，丢弃了旧消息时返回OSAL_MSG_DROPPED
+ */
+uint8_t osal_msg_send_nodrop(struct osal_tcb *task, uint8_t *msg);
+
+/**
+ * @brief 从任务的消息队列头部取出一条消息
+ * 队列中还有消息时保持OSAL_SYS_EVENT_MSG事件，否则清除该事件
+ *
+ * @param task 任务指针
+ * @return uint8_t* 消息缓冲区指针，队列为空时返回NULL
+ */
+uint8_t *osal_msg_receive(struct osal_tcb *task);
+
+/**
+ * @brief 查看任务消息队列头部的消息，消息仍保留在队列中
+ *
+ * @param task 任务指针
+ * @return uint8_t* 消息缓冲区指针，队列为空时返回NULL
+ */
+uint8_t *osal_msg_peek(const struct osal_tcb *task);
+
+/**
+ * @brief 设置任务消息队列的容量和队列已满时的处理策略
+ * 一般在osal_add_task之后立即调用，默认不限制容量
+ *
+ * @param task 任务指针
+ * @param max_cnt 最多容纳的消息数量，0表示不限制
+ * @param max_bytes 最多容纳的消息字节数，0表示不限制
+ * @param policy 队列已满时的处理策略，OSAL_MSG_POLICY_XXX
+ */
+void osal_msg_set_limit(struct osal_tcb *task, uint16_t max_cnt,
+                        uint32_t max_bytes, uint8_t policy);
+
+/**
+ * @brief 获取任务消息队列中的消息数量
+ *
+ * @param task 任务指针
+ * @return uint16_t 消息数量
+ */
+uint16_t osal_msg_count(const struct osal_tcb *task);
+
+/**
+ * @brief 获取任务因队列已满而丢弃的消息数量
+ *
+ * @param task 任务指针
+ * @return uint16_t 丢弃的消息数量
+ */
+uint16_t osal_msg_dropped(const struct osal_tcb *task);
+
+/**
+ * @brief 任务订阅主题，之后发布到该主题的消息都会放到任务的消息队列中
+ *
+ * @param task 任务指针
+ * @param topic 主题，取值范围0~OSAL_MAX_TOPICS-1
+ * @return uint8_t 成功或已经订阅过返回OSAL_OK，重复订阅不会重复收到消息
+ */
+uint8_t osal_subscribe(struct osal_tcb *task, uint8_t topic);
+
+/**
+ * @brief 任务取消订阅主题
+ *
+ * @param task 任务指针
+ * @param topic 主题
+ * @return uint8_t 成功返回OSAL_OK
+ */
+uint8_t osal_unsubscribe(struct osal_tcb *task, uint8_t topic);
+
+/**
+ * @brief 将osal_msg_allocate申请的消息发布到主题，所有订阅任务共享同一个消息缓冲区
+ * 接收任务只能读取广播消息，最后一个接收任务调用osal_msg_deallocate后释放缓冲区。
+ * 调用后消息缓冲区的所有权转移给订阅任务，没有订阅任务或全部订阅任务队列已满时缓冲区会被释放
+ *
+ * @param topic 主题
+ * @param msg 消息缓冲区指针
+ * @return uint8_t 全部订阅任务都收到消息时返回OSAL_OK，否则返回最后一个失败原因
+ */
+uint8_t osal_publish(uint8_t topic, uint8_t *msg);
+
+#if OSAL_MSG_MPSC
+/**
+ * @brief 从其他线程向任务投递osal_msg_allocate申请的消息缓冲区，不进入临界区
+ * 消息先放入任务的无锁收件箱，osal在下一次调度前按发送顺序移入任务消息队列。
+ * 移入时队列已满，按OSAL_MSG_POLICY_DROP_NEWEST处理，发送端不会收到OSAL_MSG_QUEUE_FULL
+ * 多实例时投递线程必须先用osal_ctx_bind绑定到任务所属的实例，并在该实例中申请消息缓冲区
+ *
+ * @param task 任务指针
+ * @param msg 消息缓冲区指针
+ * @return uint8_t 成功返回OSAL_OK
+ */
+uint8_t osal_msg_post(struct osal_tcb *task, uint8_t *msg);
+
+/**
+ * @brief 从其他线程置位任务的事件，不进入临界区，osal在下一次调度前合并到任务事件中
+ * 只访问任务自身和所属实例的收件箱标志，是唯一可以跨实例调用的接口
+ *
+ * @param task 任务指针
+ * @param event_flag 期望设置的事件
+ */
+void osal_event_post(struct osal_tcb *task, osal_event_t event_flag);
+#endif
+
+#if OSAL_EVT_RING
+/**
+ * @brief 发送携带少量数据的事件，数据拷贝到任务内部的环形队列中，不申请内存
+ * 发送后置位接收任务的OSAL_SYS_EVENT_DATA事件
+ *
+ * @param task 任务指针
+ * @param tag 事件标签，由应用定义，用于区分数据类型
+ * @param data 事件数据
+ * @param len 数据长度，不能超过OSAL_EVT_DATA_MAX
+ * @return uint8_t 成功返回OSAL_OK，队列已满返回OSAL_MSG_QUEUE_FULL
+ */
+uint8_t osal_send_evt(struct osal_tcb *task, uint8_t tag, const void *data,
+                      uint8_t len);
+
+/**
+ * @brief 从任务的小数据事件队列头部取出一个事件
+ * 队列中还有事件时保持OSAL_SYS_EVENT_DATA事件，否则清除该事件
+ *
+ * @param task 任务指针
+ * @param tag 返回事件标签，可以为NULL
+ * @param data 返回事件数据，缓冲区至少OSAL_EVT_DATA_MAX字节，可以为NULL
+ * @return int16_t 数据长度，队列为空时返回-1
+ */
+int16_t osal_evt_receive(struct osal_tcb *task, uint8_t *tag, void *data);
+#endif
@@ -56,3 +56,12 @@ void hal_tick_start(void);
  */
 void hal_tick_stop(void);
 
+/**
+ * @brief 映射持久化内存区域，开启OSALMEM_PERSIST时堆放在该区域中
+ * 区域内容需要在程序重启后保持不变，并且尽量映射到相同的地址，
+ * 首次映射时内容应全部为0
+ *
+ * @param size 区域大小
+ * @return void* 区域地址
+ */
+void *hal_mem_persist_map(uint32_t size);
@@ -0,0 +1,306 @@
+/**
+ * @file osal_rpc.c
+ * @author ljgabc
+ * @brief 任务间请求/应答调用
+ * @version 0.1
+ * @date 2024-12-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "osal.h"
+#include <string.h>
+
+#if OSAL_MAX_CALLS
+
+// 调用状态
+#define OSAL_RPC_FREE 0    // 空闲
+#define OSAL_RPC_PENDING 1 // 等待应答
+#define OSAL_RPC_DONE 2    // 已应答
+#define OSAL_RPC_EXPIRED 3 // 已超时
+
+// 等待应答的调用
+struct osal_rpc_call {
+  struct osal_tcb *caller; // 调用方任务
+  uint8_t *reply;          // 应答消息
+  uint16_t id;             // 调用ID
+  osal_event_t reply_event; // 应答事件
+  uint16_t timeout;        // 剩余超时时间，0表示不超时
+  uint8_t state;           // 调用状态
+};
+
+// 调用模块状态，每个内核实例一份
+struct osal_rpc_state {
+  struct osal_rpc_call rpc_calls[OSAL_MAX_CALLS]; // 调用表
+  uint16_t rpc_last_id;                           // 最近分配的调用ID
+  uint8_t rpc_timed_cnt; // 设置了超时时间的等待调用数量
+};
+
+static struct osal_rpc_state rpc_state[OSAL_MAX_CTX];
+
+// 当前内核实例的调用模块状态
+#define rpc_calls (rpc_state[osal_ctx_current()].rpc_calls)
+#define rpc_last_id (rpc_state[osal_ctx_current()].rpc_last_id)
+#define rpc_timed_cnt (rpc_state[osal_ctx_current()].rpc_timed_cnt)
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static struct osal_rpc_call *osal_rpc_find(uint16_t id);
+static void osal_rpc_free(struct osal_rpc_call *call);
+
+/**
+ * @brief 初始化调用表
+ *
+ */
+void osal_rpc_init(void) {
+  memset(rpc_calls, 0, sizeof(rpc_calls));
+  rpc_last_id = 0;
+  rpc_timed_cnt = 0;
+}
+
+/**
+ * @brief 查找调用，调用者需处于临界区
+ *
+ * @param id 调用ID
+ * @return struct osal_rpc_call* 找不到返回NULL
+ */
+static struct osal_rpc_call *osal_rpc_find(uint16_t id) {
+  for (uint8_t i = 0; i < OSAL_MAX_CALLS; i++) {
+    if ((rpc_calls[i].state != OSAL_RPC_FREE) && (rpc_calls[i].id == id)) {
+      return &rpc_calls[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief 释放调用表项，调用者需处于临界区
+ *
+ * @param call 调用
+ */
+static void osal_rpc_free(struct osal_rpc_call *call) {
+  if ((call->state == OSAL_RPC_PENDING) && (call->timeout != 0)) {
+    rpc_timed_cnt--;
+  }
+  call->state = OSAL_RPC_FREE;
+  call->caller = NULL;
+  call->reply = NULL;
+}
+
+/**
+ * @brief 向任务发送请求消息，只能在任务事件处理函数中调用，当前任务作为调用方
+ * req由osal_msg_allocate申请，开始位置为struct osal_rpc_hdr，调用后所有权转移给接收任务，
+ * 调用失败时req会被释放
+ *
+ * @param task 接收请求的任务
+ * @param req 请求消息
+ * @param reply_event 应答到达或超时后置位调用方的事件
+ * @param timeout 超时时间，单位ms，0表示不超时
+ * @return uint16_t 调用ID，失败返回0
+ */
+uint16_t osal_call(struct osal_tcb *task, uint8_t *req, osal_event_t reply_event,
+                   uint16_t timeout) {
+  if (req == NULL) {
+    return 0;
+  }
+
+  struct osal_tcb *caller = osal_task_self();
+  if ((task == NULL) || (caller == NULL) ||
+      (osal_msg_len(req) < sizeof(struct osal_rpc_hdr))) {
+    osal_msg_deallocate(req);
+    return 0;
+  }
+
+  struct osal_rpc_call *call = NULL;
+  uint16_t id = 0;
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  for (uint8_t i = 0; i < OSAL_MAX_CALLS; i++) {
+    if (rpc_calls[i].state == OSAL_RPC_FREE) {
+      call = &rpc_calls[i];
+      break;
+    }
+  }
+
+  if (call != NULL) {
+    // 跳过0和仍在使用的ID
+    do {
+      id = ++rpc_last_id;
+    } while ((id == 0) || (osal_rpc_find(id) != NULL));
+
+    call->caller = caller;
+    call->reply = NULL;
+    call->id = id;
+    call->reply_event = reply_event;
+    call->timeout = timeout;
+    call->state = OSAL_RPC_PENDING;
+    if (timeout != 0) {
+      rpc_timed_cnt++;
+    }
+  }
+  hal_exit_critical(cpu_sr);
+
+  if (call == NULL) {
+    osal_msg_deallocate(req);
+    return 0;
+  }
+
+  struct osal_rpc_hdr *hdr = (struct osal_rpc_hdr *)req;
+  hdr->id = id;
+  hdr->status = OSAL_OK;
+
+  // 请求不会被接收方的队列策略丢弃，放不下时直接失败并释放调用表项
+  if (osal_msg_send_nodrop(task, req) == OSAL_MSG_QUEUE_FULL) {
+    osal_msg_deallocate(req);
+    cpu_sr = hal_enter_critical();
+    osal_rpc_free(call);
+    hal_exit_critical(cpu_sr);
+    return 0;
+  }
+
+  return id;
+}
+
+/**
+ * @brief 应答请求，应答方处理完请求后调用，请求消息仍需应答方自己释放
+ * reply由osal_msg_allocate申请，开始位置为struct osal_rpc_hdr，调用后所有权转移给调用方，
+ * 调用已超时或被取消时reply会被释放
+ *
+ * @param req 请求消息
+ * @param reply 应答消息，为NULL时只通知调用方完成
+ * @return uint8_t 成功返回OSAL_OK，找不到对应调用返回OSAL_RPC_NO_CALL
+ */
+uint8_t osal_rpc_reply(const uint8_t *req, uint8_t *reply) {
+  if (req == NULL) {
+    osal_msg_deallocate(reply);
+    return OSAL_INVALID_MSG_POINTER;
+  }
+
+  const uint16_t id = ((const struct osal_rpc_hdr *)req)->id;
+  if (reply != NULL) {
+    ((struct osal_rpc_hdr *)reply)->id = id;
+  }
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  struct osal_rpc_call *call = osal_rpc_find(id);
+  if ((call == NULL) || (call->state != OSAL_RPC_PENDING)) {
+    hal_exit_critical(cpu_sr);
+    osal_msg_deallocate(reply);
+    return OSAL_RPC_NO_CALL;
+  }
+
+  if (call->timeout != 0) {
+    rpc_timed_cnt--;
+  }
+  call->reply = reply;
+  call->state = OSAL_RPC_DONE;
+  osal_set_event(call->caller, call->reply_event);
+  hal_exit_critical(cpu_sr);
+
+  return OSAL_OK;
+}
+
+/**
+ * @brief 取出任务一个已完成的调用结果，在reply_event事件中调用
+ * 还有其他已完成的调用时保持reply_event事件
+ *
+ * @param task 调用方任务
+ * @param reply_event 调用时指定的应答事件
+ * @param id 返回调用ID，可以为NULL
+ * @param reply 返回应答消息，需要调用方用osal_msg_deallocate释放，超时时为NULL
+ * @return uint8_t 应答返回OSAL_OK，超时返回OSAL_RPC_TIMEOUT，没有已完成的调用返回OSAL_RPC_NO_CALL
+ */
+uint8_t osal_rpc_result(struct osal_tcb *task, osal_event_t reply_event,
+                        uint16_t *id, uint8_t **reply) {
+  uint8_t ret = OSAL_RPC_NO_CALL;
+  bool more = false;
+
+  if (reply) {
+    *reply = NULL;
+  }
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  for (uint8_t i = 0; i < OSAL_MAX_CALLS; i++) {
+    struct osal_rpc_call *call = &rpc_calls[i];
+    if ((call->caller != task) || (call->reply_event != reply_event) ||
+        ((call->state != OSAL_RPC_DONE) && (call->state != OSAL_RPC_EXPIRED))) {
+      continue;
+    }
+
+    if (ret != OSAL_RPC_NO_CALL) {
+      more = true;
+      break;
+    }
+
+    ret = (call->state == OSAL_RPC_DONE) ? OSAL_OK : OSAL_RPC_TIMEOUT;
+    if (id) {
+      *id = call->id;
+    }
+    if (reply) {
+      *reply = call->reply;
+    } else {
+      osal_msg_deallocate(call->reply);
+    }
+    osal_rpc_free(call);
+  }
+
+  if (more) {
+    osal_set_event(task, reply_event);
+  }
+  hal_exit_critical(cpu_sr);
+
+  return ret;
+}
+
+/**
+ * @brief 取消调用，之后到达的应答会被丢弃
+ *
+ * @param id 调用ID
+ * @return uint8_t 成功返回OSAL_OK
+ */
+uint8_t osal_rpc_cancel(uint16_t id) {
+  hal_reg_t cpu_sr = hal_enter_critical();
+  struct osal_rpc_call *call = osal_rpc_find(id);
+  uint8_t *reply = NULL;
+  if (call != NULL) {
+    reply = call->reply;
+    osal_rpc_free(call);
+  }
+  hal_exit_critical(cpu_sr);
+
+  if (call == NULL) {
+    return OSAL_RPC_NO_CALL;
+  }
+  osal_msg_deallocate(reply);
+  return OSAL_OK;
+}
+
+/**
+ * @brief 更新调用的超时时间，由osal_tick调用
+ *
+ * @param ms 时间，单位ms
+ */
+void osal_rpc_tick(uint16_t ms) {
+  if (rpc_timed_cnt == 0) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < OSAL_MAX_CALLS; i++) {
+    hal_reg_t cpu_sr = hal_enter_critical();
+    struct osal_rpc_call *call = &rpc_calls[i];
+    if ((call->state == OSAL_RPC_PENDING) && (call->timeout != 0)) {
+      if (call->timeout <= ms) {
+        call->timeout = 0;
+        call->state = OSAL_RPC_EXPIRED;
+        rpc_timed_cnt--;
+        osal_set_event(call->caller, call->reply_event);
+      } else {
+        call->timeout -= ms;
+      }
+    }
+    hal_exit_critical(cpu_sr);
+  }
+}
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file osal_rpc.h
+ * @author ljgabc
+ * @brief 任务间请求/应答调用
+ * 调用方通过osal_call发送请求消息，应答到达或超时后置位调用方指定的事件，
+ * 调用方在该事件中通过osal_rpc_result取回结果。超时由osal_tick统一处理，不占用定时器
+ * @version 0.1
+ * @date 2024-12-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "osal_config.h"
+#include "osal_types.h"
+
+// 同时等待应答的最大调用数量，为0时不使用此功能
+#ifndef OSAL_MAX_CALLS
+#define OSAL_MAX_CALLS 0
+#endif
+
+struct osal_tcb;
+
+// 请求和应答消息的公共头部，必须放在请求和应答数据结构的开始位置
+struct osal_rpc_hdr {
+  uint16_t id;    // 调用ID，由osal_call填写，osal_rpc_reply复制到应答中
+  uint8_t status; // 应答状态，由应答方填写
+};
+
+#if OSAL_MAX_CALLS
+/**
+ * @brief 初始化调用表
+ *
+ */
+void osal_rpc_init(void);
+
+/**
+ * @brief 向任务发送请求消息，只能在任务事件处理函数中调用，当前任务作为调用方
+ * req由osal_msg_allocate申请，开始位置为struct osal_rpc_hdr，调用后所有权转移给接收任务，
+ * 调用失败时req会被释放
+ *
+ * @param task 接收请求的任务
+ * @param req 请求消息
+ * @param reply_event 应答到达或超时后置位调用方的事件
+ * @param timeout 超时时间，单位ms，0表示不超时
+ * @return uint16_t 调用ID，失败返回0
+ */
+uint16_t osal_call(struct osal_tcb *task, uint8_t *req, osal_event_t reply_event,
+                   uint16_t timeout);
+
+/**
+ * @brief 应答请求，应答方处理完请求后调用，请求消息仍需应答方自己释放
+ * reply由osal_msg_allocate申请，开始位置为struct osal_rpc_hdr，调用后所有权转移给调用方，
+ * 调用已超时或被取消时reply会被释放
+ *
+ * @param req 请求消息
+ * @param reply 应答消息，为NULL时只通知调用方完成
+ * @return uint8_t 成功返回OSAL_OK，找不到对应调用返回OSAL_RPC_NO_CALL
+ */
+uint8_t osal_rpc_reply(const uint8_t *req, uint8_t *reply);
+
+/**
+ * @brief 取出任务一个已完成的调用结果，在reply_event事件中调用
+ * 还有其他已完成的调用时保持reply_event事件
+ *
+ * @param task 调用方任务
+ * @param reply_event 调用时指定的应答事件
+ * @param id 返回调用ID，可以为NULL
+ * @param reply 返回应答消息，需要调用方用osal_msg_deallocate释放，超时时为NULL
+ * @return uint8_t 应答返回OSAL_OK，超时返回OSAL_RPC_TIMEOUT，没有已完成的调用返回OSAL_RPC_NO_CALL
+ */
+uint8_t osal_rpc_result(struct osal_tcb *task, osal_event_t reply_event,
+                        uint16_t *id, uint8_t **reply);
+
+/**
+ * @brief 取消调用，之后到达的应答会被丢弃
+ *
+ * @param id 调用ID
+ * @return uint8_t 成功返回OSAL_OK
+ */
+uint8_t osal_rpc_cancel(uint16_t id);
+
+/**
+ * @brief 更新调用的超时时间，由osal_tick调用
+ *
+ * @param ms 时间，单位ms
+ */
+void osal_rpc_tick(uint16_t ms);
+#endif
@@ -9,32 +9,195 @@
  *
  */
 #include "osal.h"
+#include "osal_tcb.h"
+#include <string.h>
+#if OSAL_MSG_MPSC || OSAL_WORKERS || OSAL_EVENT_ATOMIC
+#include <stdatomic.h>
+#endif
+#if OSAL_EVENT_ATOMIC && (OSAL_EVENT_BITS == 64) && (ATOMIC_LLONG_LOCK_FREE != 2)
+#error "OSAL_EVENT_ATOMIC needs lock-free 64-bit atomics for OSAL_EVENT_BITS 64"
+#endif
+#if OSAL_SCHED_EDF && OSAL_WORKERS
+#error "OSAL_SCHED_EDF is not supported with OSAL_WORKERS"
+#endif
+#if OSAL_WORKERS
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#endif
 
+// 消息头，位于消息缓冲区之前
 struct osal_msg_hdr {
   struct osal_msg_hdr *next;
   uint16_t len;
+  uint8_t ref;   // 引用计数，广播消息被所有接收任务释放后才释放缓冲区
+  uint8_t flags; // 消息标志
 };
 
-/**
- * @brief 任务控制块实现
- */
-struct osal_tcb {
-  struct osal_tcb *next;
-  task_init_fn_t init;            // 任务初始化函数指针
-  task_handler_fn_t handler;      // 任务事件处理函数指针
-  struct osal_msg_hdr *msg_list;  // 消息列表
-  uint16_t events;                // 任务事件
-  uint8_t priority;               // 任务优先级
+// 消息缓冲区的最大长度，加上消息头后不能超过osal_mem_alloc的上限
+#define OSAL_MSG_LEN_MAX (OSALMEM_ALLOC_MAX - sizeof(struct osal_msg_hdr))
+
+// 消息标志：此节点只是对广播消息的引用，本身不带数据
+#define OSAL_MSG_F_REF 0x01
+
+// 消息标志：队列放不下时不丢弃此消息，按OSAL_MSG_POLICY_REJECT处理，
+// 在队列中时也不会因为其他消息被丢弃，从队列中取出时清除
+#define OSAL_MSG_F_NODROP 0x02
+
+// 消息标志的高4位保存消息的优先级通道
+#define OSAL_MSG_F_PRIO_SHIFT 4
+#define OSAL_MSG_F_PRIO_MASK 0xF0
+#define OSAL_MSG_PRIO(hdr) ((hdr)->flags >> OSAL_MSG_F_PRIO_SHIFT)
+
+#if (OSAL_MSG_LANES < 1) || (OSAL_MSG_LANES > 16)
+#error "OSAL_MSG_LANES must be between 1 and 16"
+#endif
+
+// 广播消息的引用节点，放在除第一个订阅任务之外的其他订阅任务的消息队列中
+struct osal_msg_ref {
+  struct osal_msg_hdr hdr;
+  struct osal_msg_hdr *msg; // 被引用的广播消息
+};
+
+// 主题订阅节点
+struct osal_topic_sub {
+  struct osal_topic_sub *next;
+  struct osal_tcb *task;
+};
+
+// 任务模块状态，每个内核实例一份
+struct osal_task_state {
+  struct osal_tcb *task_list_head;                  // 任务链表表头
+  uint8_t total_task_cnt;                           // 任务总数
+  struct osal_topic_sub *topic_subs[OSAL_MAX_TOPICS]; // 各主题的订阅链表
+#if OSAL_MSG_MPSC
+  atomic_bool pending; // 有任务的收件箱或投递事件非空，调度前需要取出
+#endif
+#if OSAL_TASK_RR
+  struct osal_tcb *rr_cursor; // 上次调度的任务，同优先级的就绪任务从它之后开始查找
+#endif
+#if OSAL_SCHED_EDF
+  struct osal_tcb *edf_heap[OSAL_MAX_TASKS]; // 有截止时间的任务，按截止时间排列的最小堆
+  uint8_t edf_cnt;                           // 堆中的任务数量
+#endif
+};
+
+static struct osal_task_state task_state[OSAL_MAX_CTX];
+
+// 当前内核实例的任务模块状态
+#define task_list_head (task_state[osal_ctx_current()].task_list_head)
+#define total_task_cnt (task_state[osal_ctx_current()].total_task_cnt)
+#define topic_subs (task_state[osal_ctx_current()].topic_subs)
+#define inbox_pending (task_state[osal_ctx_current()].pending)
+#define rr_cursor (task_state[osal_ctx_current()].rr_cursor)
+#define edf_heap (task_state[osal_ctx_current()].edf_heap)
+#define edf_cnt (task_state[osal_ctx_current()].edf_cnt)
+
+#if OSAL_SCHED_EDF
+// 任务不在截止时间堆中
+#define OSAL_EDF_NONE 0xFF
+
+// 任务a的截止时间早于任务b，允许时间回绕
+#define OSAL_EDF_BEFORE(a, b) ((int32_t)((a)->deadline - (b)->deadline) < 0)
+
+static void osal_edf_remove(struct osal_tcb *task);
+#endif
+
+// 任务所属内核实例的收件箱标志，其他线程投递时使用
+#if OSAL_MAX_CTX > 1
+#define OSAL_TASK_INBOX_PENDING(task) (task_state[(task)->ctx].pending)
+#else
+#define OSAL_TASK_INBOX_PENDING(task) inbox_pending
+#endif
+
+// 任务必须属于当前线程绑定的内核实例，临界区和内存堆都按当前实例选择
+#if OSAL_MAX_CTX > 1
+#define OSAL_TASK_CTX_CHECK(task) HAL_ASSERT((task)->ctx == osal_ctx_current())
+#else
+#define OSAL_TASK_CTX_CHECK(task) ((void)0)
+#endif
+
+// 当前正在执行的任务
+#if OSAL_WORKERS || (OSAL_MAX_CTX > 1)
+static _Thread_local struct osal_tcb *current_task = NULL;
+#else
+static struct osal_tcb *current_task = NULL;
+#endif
+
+#if OSAL_MSG_MPSC
+static void osal_msg_inbox_drain(void);
+#endif
+static osal_event_t osal_task_take_events(struct osal_tcb *task);
+static void osal_task_setup(struct osal_tcb *task_new, task_init_fn_t init,
+                            task_handler_fn_t handler, uint8_t priority);
+static void osal_task_link(struct osal_tcb *task_new);
+static osal_event_t osal_task_dispatch(struct osal_tcb *task,
+                                       osal_event_t events);
+
+#if OSAL_TASK_STATIC
+// OSAL_TASK_SECTION段的起止地址，没有静态任务时为NULL
+extern struct osal_tcb __start_osal_tasks[] __attribute__((weak));
+extern struct osal_tcb __stop_osal_tasks[] __attribute__((weak));
+#endif
+
+#if OSAL_EVENT_TABLE
+// 最低有效位的序号，x不能为0
+#if defined(__GNUC__) && (OSAL_EVENT_BITS == 64)
+#define OSAL_CTZ(x) ((uint8_t)__builtin_ctzll(x))
+#elif defined(__GNUC__)
+#define OSAL_CTZ(x) ((uint8_t)__builtin_ctz(x))
+#else
+static uint8_t osal_ctz(osal_event_t x) {
+  uint8_t idx = 0;
+  while ((x & 1) == 0) {
+    x >>= 1;
+    idx++;
+  }
+  return idx;
+}
+#define OSAL_CTZ(x) osal_ctz(x)
+#endif
+#endif
+
+#if OSAL_WORKERS
+// 任务调度状态
+#define OSAL_TASK_IDLE 0    // 没有待处理的事件
+#define OSAL_TASK_QUEUED 1  // 在某个工作线程的就绪队列中
+#define OSAL_TASK_RUNNING 2 // 正在某个工作线程中执行
+
+// 空闲工作线程的最长等待时间
+#define OSAL_WORKER_IDLE_NS 10000000L
+
+// 工作线程
+struct osal_worker {
+  pthread_mutex_t lock;   // 保护就绪队列
+  struct osal_tcb *ready; // 就绪队列，按任务优先级从高到低排列
+  pthread_t thread;
 };
 
-// 任务链表表头
-static struct osal_tcb *task_list_head = NULL;
+static struct osal_worker workers[OSAL_WORKERS];
+static bool workers_started; // 工作线程已启动，受临界区保护
+static pthread_mutex_t idle_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t idle_cond = PTHREAD_COND_INITIALIZER;
+static atomic_uint idle_cnt; // 正在等待的空闲工作线程数量
+#if OSAL_MSG_MPSC
+static pthread_mutex_t inbox_lock = PTHREAD_MUTEX_INITIALIZER; // 保证收件箱按顺序取出
+#endif
 
-// 任务总数
-static uint8_t total_task_cnt = 0;
+static void osal_task_signal(struct osal_tcb *task);
+static void osal_worker_wake(void);
+#else
+// 单线程调度时由osal_next_active_task查找就绪任务
+#define osal_task_signal(task) ((void)0)
+#endif
 
+// 消息头到消息缓冲区
 #define OSAL_MSG_BUFFER(msg_ptr) (uint8_t *)((struct osal_msg_hdr *)msg_ptr + 1)
 
+// 消息缓冲区到消息头
+#define OSAL_MSG_HDR(msg_ptr) ((struct osal_msg_hdr *)(msg_ptr)-1)
+
 /**
  * @brief 初始化任务列表
  *
@@ -42,6 +205,20 @@ static uint8_t total_task_cnt = 0;
 void osal_task_init(void) {
   task_list_head = (struct osal_tcb *)NULL;
   total_task_cnt = 0;
+  current_task = NULL;
+  memset(topic_subs, 0, sizeof(topic_subs));
+#if OSAL_WORKERS
+  workers_started = false;
+#endif
+#if OSAL_MSG_MPSC
+  atomic_store(&inbox_pending, false);
+#endif
+#if OSAL_TASK_RR
+  rr_cursor = NULL;
+#endif
+#if OSAL_SCHED_EDF
+  edf_cnt = 0;
+#endif
 }
 
 /**
@@ -51,11 +228,17 @@ void osal_task_init(void) {
  * @param event_flag 期望设置的事件
  * @return int8 成功返回0
  */
-void osal_set_event(struct osal_tcb *task, uint16_t event_flag) {
+void osal_set_event(struct osal_tcb *task, osal_event_t event_flag) {
   if (task) {
+    OSAL_TASK_CTX_CHECK(task);
+#if OSAL_EVENT_ATOMIC && !OSAL_WORKERS
+    atomic_fetch_or_explicit(&task->events, event_flag, memory_order_release);
+#else
     hal_reg_t cpu_sr = hal_enter_critical();
     task->events |= event_flag;
+    osal_task_signal(task);
     hal_exit_critical(cpu_sr);
+#endif
   }
 }
 
@@ -66,11 +249,17 @@ void osal_set_event(struct osal_tcb *task, uint16_t event_flag) {
  * @param event_flag 期望清除的事件
  * @return int8 成功返回0
  */
-void osal_clear_event(struct osal_tcb *task, uint16_t event_flag) {
+void osal_clear_event(struct osal_tcb *task, osal_event_t event_flag) {
   if (task) {
+    OSAL_TASK_CTX_CHECK(task);
+#if OSAL_EVENT_ATOMIC
+    atomic_fetch_and_explicit(&task->events, (osal_event_t)~event_flag,
+                              memory_order_relaxed);
+#else
     hal_reg_t cpu_sr = hal_enter_critical();
     task->events &= ~event_flag;
     hal_exit_critical(cpu_sr);
+#endif
   }
 }
 
@@ -79,14 +268,18 @@ void osal_clear_event(struct osal_tcb *task, uint16_t event_flag) {
  *
  * @param task 任务
 
- * @return uint16_t 事件标志
+ * @return osal_event_t 事件标志
  */
-uint16_t osal_get_event(const struct osal_tcb *task) {
-  uint16_t event_flag = 0;
+osal_event_t osal_get_event(const struct osal_tcb *task) {
+  osal_event_t event_flag = 0;
   if (task) {
+#if OSAL_EVENT_ATOMIC
+    event_flag = atomic_load_explicit(&task->events, memory_order_acquire);
+#else
     hal_reg_t cpu_sr = hal_enter_critical();
     event_flag = task->events;
     hal_exit_critical(cpu_sr);
+#endif
   }
   return event_flag;
 }
@@ -99,7 +292,9 @@ void osal_task_runinit(void) {
   for (struct osal_tcb *task = task_list_head; task != NULL;
        task = task->next) {
     if (task->init) {
+      current_task = task;
       task->init(task);
+      current_task = NULL;
     }
   }
 }
@@ -109,22 +304,52 @@ void osal_task_runinit(void) {
  *
  */
 void osal_task_polling(void) {
+#if OSAL_MSG_MPSC
+  // 取出其他线程投递的消息和事件
+  if (atomic_exchange_explicit(&inbox_pending, false, memory_order_acquire)) {
+    osal_msg_inbox_drain();
+  }
+#endif
+
   // 获取就绪的任务
   struct osal_tcb *task = osal_next_active_task();
 
   if (task) {
-    // 暂存任务事件标志并清零
+#if OSAL_TASK_RR
+    rr_cursor = task;
+#endif
+#if OSAL_SCHED_EDF
+    // 本次调度满足了任务的截止时间
+    hal_reg_t edf_sr = hal_enter_critical();
+    if (task->edf_idx != OSAL_EDF_NONE) {
+      osal_edf_remove(task);
+    }
+    hal_exit_critical(edf_sr);
+#endif
+
+    // 取出本次要处理的事件标志
+#if OSAL_EVENT_ATOMIC
+    osal_event_t events = osal_task_take_events(task);
+#else
     hal_reg_t cpu_sr = hal_enter_critical();
-    uint16_t events = task->events;
-    task->events = 0;
+    osal_event_t events = osal_task_take_events(task);
     hal_exit_critical(cpu_sr);
+#endif
 
     // 执行任务处理函数，返回需要再次置位的事件标志
-    if (events != 0 && task->handler) {
-      events = (task->handler)(task, events);
+    if (events != 0) {
+      current_task = task;
+      events = osal_task_dispatch(task, events);
+      current_task = NULL;
       osal_set_event(task, events);
     }
   }
+#if OSALMEM_HANDLE
+  else {
+    // 没有就绪任务时整理内存碎片
+    osal_mem_compact();
+  }
+#endif
 }
 
 /**
@@ -150,50 +375,385 @@ struct osal_tcb *osal_add_task(task_init_fn_t init, task_handler_fn_t handler,
   struct osal_tcb *task_new = osal_mem_alloc(sizeof(struct osal_tcb));
 
   if (task_new) {
-    task_new->init = init;
-    task_new->handler = handler;
-    task_new->events = 0;
-    task_new->priority = priority;
-    task_new->next = (struct osal_tcb *)NULL;
-
-    struct osal_tcb **prev_task_ptr = &task_list_head;
-    for (struct osal_tcb *task = task_list_head; task != NULL;
-         task = task->next) {
-      if (task_new->priority > task->priority) {
-        task_new->next = task;
-        *prev_task_ptr = task_new;
-        return task_new;
-      }
-      prev_task_ptr = &task->next;
+    osal_task_setup(task_new, init, handler, priority);
+    osal_task_link(task_new);
+  }
+  return task_new;
+}
+
+#if OSAL_TASK_STATIC
+/**
+ * @brief 将OSAL_TASK_DEFINE定义的静态任务按优先级加入默认实例的任务链表，由osal_init调用
+ * 静态任务总数超过OSAL_MAX_TASKS剩余的数量时断言失败，一个静态任务也不加入，
+ * 避免部分任务通过导出的指针可以访问却永远不被调度。
+ * 任务控制块的地址已经通过OSAL_TASK_DEFINE导出，段不能原地排序，每个任务与osal_add_task
+ * 一样按优先级插入链表，n个静态任务的开销是O(n^2)，只在启动时发生一次
+ *
+ * @return uint8_t 成功返回OSAL_OK，任务数量超过OSAL_MAX_TASKS时返回OSAL_TOO_MANY_TASKS
+ */
+uint8_t osal_task_register_static(void) {
+  if ((osal_ctx_current() != OSAL_DEFAULT_CTX) || (__start_osal_tasks == NULL)) {
+    return OSAL_OK;
+  }
+  const size_t cnt = (size_t)(__stop_osal_tasks - __start_osal_tasks);
+  HAL_ASSERT(cnt <= (size_t)(OSAL_MAX_TASKS - total_task_cnt));
+  if (cnt > (size_t)(OSAL_MAX_TASKS - total_task_cnt)) {
+    return OSAL_TOO_MANY_TASKS;
+  }
+  for (struct osal_tcb *task = __start_osal_tasks; task < __stop_osal_tasks;
+       task++) {
+    total_task_cnt++;
+    osal_task_setup(task, task->init, task->handler, task->priority);
+    osal_task_link(task);
+  }
+  return OSAL_OK;
+}
+#endif
+
+/**
+ * @brief 初始化任务控制块
+ *
+ * @param task_new 任务控制块
+ * @param init 任务初始化函数
+ * @param handler 任务事件处理函数
+ * @param priority 任务优先级
+ */
+static void osal_task_setup(struct osal_tcb *task_new, task_init_fn_t init,
+                            task_handler_fn_t handler, uint8_t priority) {
+  task_new->init = init;
+  task_new->handler = handler;
+  memset(task_new->msg_head, 0, sizeof(task_new->msg_head));
+  memset(task_new->msg_tail, 0, sizeof(task_new->msg_tail));
+  task_new->msg_cnt = 0;
+  task_new->msg_max_cnt = 0;
+  task_new->msg_bytes = 0;
+  task_new->msg_max_bytes = 0;
+  task_new->msg_dropped = 0;
+  task_new->msg_policy = OSAL_MSG_POLICY_REJECT;
+#if OSAL_MSG_MPSC
+  atomic_init(&task_new->inbox, NULL);
+  atomic_init(&task_new->post_events, 0);
+#endif
+#if OSAL_EVT_RING
+  task_new->evt_head = 0;
+  task_new->evt_cnt = 0;
+#endif
+#if OSAL_WORKERS
+  task_new->ready_next = NULL;
+  task_new->sched_state = OSAL_TASK_IDLE;
+  task_new->worker = (uint8_t)(total_task_cnt % OSAL_WORKERS);
+#endif
+#if OSAL_MAX_CTX > 1
+  task_new->ctx = osal_ctx_current();
+#endif
+#if OSAL_EVENT_TABLE
+  memset(task_new->event_fn, 0, sizeof(task_new->event_fn));
+#endif
+#if OSAL_COROUTINE
+  task_new->co.line = 0;
+  task_new->co.events = 0;
+#endif
+#if OSAL_SCHED_EDF
+  task_new->deadline = 0;
+  task_new->edf_idx = OSAL_EDF_NONE;
+#endif
+#if OSAL_EVENT_BUDGET
+  task_new->event_cursor = OSAL_EVENT_BITS - 1;
+#endif
+  task_new->events = 0;
+  task_new->priority = priority;
+  task_new->next = (struct osal_tcb *)NULL;
+}
+
+/**
+ * @brief 将任务按优先级插入任务链表，放在相同优先级的任务之后
+ *
+ * @param task_new 任务控制块
+ */
+static void osal_task_link(struct osal_tcb *task_new) {
+  struct osal_tcb **prev_task_ptr = &task_list_head;
+  for (struct osal_tcb *task = task_list_head; task != NULL;
+       task = task->next) {
+    if (task_new->priority > task->priority) {
+      task_new->next = task;
+      *prev_task_ptr = task_new;
+      return;
     }
-    *prev_task_ptr = task_new;
+    prev_task_ptr = &task->next;
   }
-  return ((struct osal_tcb *)NULL);
+  *prev_task_ptr = task_new;
 }
 
 /**
- * @brief 获取最高优先级的就绪任务的任务控制块
+ * @brief 获取当前正在执行事件处理函数或初始化函数的任务
+ *
+ * @return struct osal_tcb* 当前任务，不在任务上下文中时返回NULL
+ */
+struct osal_tcb *osal_task_self(void) { return current_task; }
+
+#if OSAL_COROUTINE
+/**
+ * @brief 获取任务的协程状态
+ *
+ * @param task 任务
+ * @return struct osal_co* 协程状态
+ */
+struct osal_co *osal_task_co(struct osal_tcb *task) { return &task->co; }
+#endif
+
+/**
+ * @brief 获取最高优先级的就绪任务的任务控制块，开启OSAL_TASK_RR时同优先级任务轮流返回，
+ * 开启OSAL_SCHED_EDF时先返回截止时间最早的就绪任务
  *
  * @return struct osal_tcb* 最高优先级的就绪任务
  */
 struct osal_tcb *osal_next_active_task(void) {
+#if OSAL_SCHED_EDF
+  // 堆顶任务的事件已被清除时不再就绪，移出堆
+  hal_reg_t cpu_sr = hal_enter_critical();
+  while (edf_cnt > 0) {
+    struct osal_tcb *task = edf_heap[0];
+    if (task->events) {
+      hal_exit_critical(cpu_sr);
+      return task;
+    }
+    osal_edf_remove(task);
+  }
+  hal_exit_critical(cpu_sr);
+#endif
+
+  struct osal_tcb *first = NULL;
   for (struct osal_tcb *task = task_list_head; task != NULL;
        task = task->next) {
     if (task->events) {
-      return task;
+      first = task;
+      break;
+    }
+  }
+
+#if OSAL_TASK_RR
+  // 上次调度的任务与最高就绪优先级相同时，从它之后查找同优先级的就绪任务，
+  // 找不到时回到同优先级的第一个就绪任务
+  if ((first != NULL) && (rr_cursor != NULL) &&
+      (rr_cursor->priority == first->priority)) {
+    for (struct osal_tcb *task = rr_cursor->next;
+         (task != NULL) && (task->priority == first->priority);
+         task = task->next) {
+      if (task->events) {
+        return task;
+      }
+    }
+  }
+#endif
+
+  return first;
+}
+
+#if OSAL_SCHED_EDF
+/**
+ * @brief 交换截止时间堆中的两个任务，调用者需在临界区中
+ *
+ * @param i 位置
+ * @param j 位置
+ */
+static void osal_edf_swap(uint8_t i, uint8_t j) {
+  struct osal_tcb *task = edf_heap[i];
+  edf_heap[i] = edf_heap[j];
+  edf_heap[j] = task;
+  edf_heap[i]->edf_idx = i;
+  edf_heap[j]->edf_idx = j;
+}
+
+/**
+ * @brief 截止时间提前后向堆顶调整，调用者需在临界区中
+ *
+ * @param idx 位置
+ */
+static void osal_edf_up(uint8_t idx) {
+  while (idx > 0) {
+    const uint8_t parent = (uint8_t)((idx - 1) / 2);
+    if (!OSAL_EDF_BEFORE(edf_heap[idx], edf_heap[parent])) {
+      break;
+    }
+    osal_edf_swap(idx, parent);
+    idx = parent;
+  }
+}
+
+/**
+ * @brief 向堆底调整，调用者需在临界区中
+ *
+ * @param idx 位置
+ */
+static void osal_edf_down(uint8_t idx) {
+  for (;;) {
+    uint8_t min = idx;
+    const uint16_t left = (uint16_t)(2 * idx + 1);
+    const uint16_t right = (uint16_t)(left + 1);
+    if ((left < edf_cnt) && OSAL_EDF_BEFORE(edf_heap[left], edf_heap[min])) {
+      min = (uint8_t)left;
+    }
+    if ((right < edf_cnt) &&
+        OSAL_EDF_BEFORE(edf_heap[right], edf_heap[min])) {
+      min = (uint8_t)right;
+    }
+    if (min == idx) {
+      break;
+    }
+    osal_edf_swap(idx, min);
+    idx = min;
+  }
+}
+
+/**
+ * @brief 将任务移出截止时间堆，调用者需在临界区中
+ *
+ * @param task 任务，必须在堆中
+ */
+static void osal_edf_remove(struct osal_tcb *task) {
+  const uint8_t idx = task->edf_idx;
+  const uint8_t last = --edf_cnt;
+  task->edf_idx = OSAL_EDF_NONE;
+  if (idx != last) {
+    edf_heap[idx] = edf_heap[last];
+    edf_heap[idx]->edf_idx = idx;
+    osal_edf_up(idx);
+    osal_edf_down(edf_heap[idx]->edf_idx);
+  }
+}
+
+/**
+ * @brief 置位任务的事件并指定截止时间
+ *
+ * @param task 任务
+ * @param event_flag 期望设置的事件
+ * @param deadline 截止时间，从现在开始的ms数
+ */
+void osal_set_event_deadline(struct osal_tcb *task, osal_event_t event_flag,
+                             uint16_t deadline) {
+  if (task == NULL) {
+    return;
+  }
+  OSAL_TASK_CTX_CHECK(task);
+
+  const uint32_t due = osal_millis() + deadline;
+  hal_reg_t cpu_sr = hal_enter_critical();
+  task->events |= event_flag;
+  if (task->edf_idx == OSAL_EDF_NONE) {
+    task->deadline = due;
+    task->edf_idx = edf_cnt;
+    edf_heap[edf_cnt++] = task;
+    osal_edf_up(task->edf_idx);
+  } else if ((int32_t)(due - task->deadline) < 0) {
+    task->deadline = due;
+    osal_edf_up(task->edf_idx);
+  }
+  hal_exit_critical(cpu_sr);
+}
+#endif
+
+/**
+ * @brief 取出任务本次调度要处理的事件，调用者需在临界区中，开启OSAL_EVENT_ATOMIC时不需要
+ *
+ * @param task 任务
+ * @return osal_event_t 交给处理函数的事件，未取出的事件保留在任务中
+ */
+static osal_event_t osal_task_take_events(struct osal_tcb *task) {
+#if OSAL_EVENT_BUDGET
+  osal_event_t events = 0;
+  uint8_t budget = OSAL_EVENT_BUDGET;
+#if OSAL_EVENT_ATOMIC
+  const osal_event_t pending =
+      atomic_load_explicit(&task->events, memory_order_acquire);
+#else
+  const osal_event_t pending = task->events;
+#endif
+  // 从上次取到的最后一位的下一位开始向低位扫描，到最低位后回到最高位，
+  // 避免高位事件一直置位时低位事件永远取不到
+  uint8_t idx = task->event_cursor;
+  for (uint8_t n = 0; (n < OSAL_EVENT_BITS) && (budget != 0); n++) {
+    const osal_event_t bit = (osal_event_t)1 << idx;
+    if (pending & bit) {
+      events |= bit;
+      budget--;
     }
+    idx = (idx == 0) ? (uint8_t)(OSAL_EVENT_BITS - 1) : (uint8_t)(idx - 1);
   }
-  return ((struct osal_tcb *)NULL);
+  task->event_cursor = idx;
+  // 只清除取出的位，期间新置位的事件保留到下次调度
+  task->events &= (osal_event_t)~events;
+#elif OSAL_EVENT_ATOMIC
+  osal_event_t events =
+      atomic_exchange_explicit(&task->events, 0, memory_order_acquire);
+#else
+  osal_event_t events = task->events;
+  task->events = 0;
+#endif
+  return events;
 }
 
+/**
+ * @brief 把事件交给任务的处理函数，注册了事件位处理函数时按位逐个调用
+ *
+ * @param task 任务
+ * @param events 本次处理的事件
+ * @return osal_event_t 需要再次置位的事件
+ */
+static osal_event_t osal_task_dispatch(struct osal_tcb *task,
+                                       osal_event_t events) {
+#if OSAL_EVENT_TABLE
+  osal_event_t unhandled = 0;
+  osal_event_t again = 0;
+  while (events != 0) {
+    const uint8_t idx = OSAL_CTZ(events);
+    const osal_event_t bit = (osal_event_t)1 << idx;
+    events &= (osal_event_t)~bit;
+    if (task->event_fn[idx]) {
+      again |= task->event_fn[idx](task, bit);
+    } else {
+      unhandled |= bit;
+    }
+  }
+  if (unhandled && task->handler) {
+    again |= task->handler(task, unhandled);
+  }
+  return again;
+#else
+  return task->handler ? task->handler(task, events) : 0;
+#endif
+}
+
+#if OSAL_EVENT_TABLE
+/**
+ * @brief 为任务的一个事件位注册处理函数
+ *
+ * @param task 任务
+ * @param event 事件，只能有一个位有效
+ * @param handler 处理函数，NULL表示取消注册
+ * @return uint8_t 成功返回OSAL_OK，task为NULL时返回OSAL_INVALID_TASK，
+ * event不是单个事件位时返回OSAL_INVALID_EVENT_ID
+ */
+uint8_t osal_set_event_handler(struct osal_tcb *task, osal_event_t event,
+                               task_handler_fn_t handler) {
+  if (task == NULL) {
+    return OSAL_INVALID_TASK;
+  }
+  if ((event == 0) || ((event & (event - 1)) != 0)) {
+    return OSAL_INVALID_EVENT_ID;
+  }
+  task->event_fn[OSAL_CTZ(event)] = handler;
+  return OSAL_OK;
+}
+#endif
+
 /**
  * @brief 任务调用此函数来分配消息缓冲区
  *
  * @param len 所需缓冲区长度
  * @return uint8_t* 指向已分配缓冲区的指针，如果分配失败，则返回 NULL
  */
-struct osal_msg_hdr *osal_msg_allocate(uint16_t len) {
-  if (len == 0) {
+uint8_t *osal_msg_allocate(uint16_t len) {
+  if ((len == 0) || (len > OSAL_MSG_LEN_MAX)) {
     return (NULL);
   }
 
@@ -203,46 +763,1280 @@ struct osal_msg_hdr *osal_msg_allocate(uint16_t len) {
   if (hdr) {
     hdr->next = NULL;
     hdr->len = len;
-    return hdr;
+    hdr->ref = 1;
+    hdr->flags = 0;
+    return OSAL_MSG_BUFFER(hdr);
   }
   return (NULL);
 }
 
 /**
  * @brief 任务完成对收到的消息处理后，调用此函数释放缓冲区
- * @param msg_ptr 指向缓冲区的指针
+ * 广播消息在最后一个接收任务释放后才真正释放
  *
- * @return uint8_t 成功返回OK
+ * @param msg 消息缓冲区指针
  */
-void osal_msg_deallocate(struct osal_msg_hdr *msg) {
+void osal_msg_deallocate(uint8_t *msg) {
   if (msg == NULL) {
     return;
   }
-  uint8_t *ptr = (uint8_t *)((uint8_t *)msg - sizeof(struct osal_msg_hdr));
-  osal_mem_free((void *)ptr);
+
+  struct osal_msg_hdr *hdr = OSAL_MSG_HDR(msg);
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  uint8_t ref = (hdr->ref > 0) ? --hdr->ref : 0;
+  hal_exit_critical(cpu_sr);
+
+  if (ref == 0) {
+    osal_mem_free((void *)hdr);
+  }
 }
 
 /**
- * @brief 将消息放到任务的消息列表中
- * 此函数会将buf中的数据拷贝到一个新消息缓冲区中，调用完此函数后buf可以被释放了。
- * 新的消息缓冲区由消息消费端来释放。
+ * @brief 获取消息长度
+ *
+ * @param msg 消息缓冲区指针
+ * @return uint16_t 消息长度
+ */
+uint16_t osal_msg_len(const uint8_t *msg) {
+  if (msg == NULL) {
+    return 0;
+  }
+  return OSAL_MSG_HDR(msg)->len;
+}
+
+/**
+ * @brief 获取队列节点对应的消息长度，广播消息的引用节点返回被引用消息的长度
+ *
+ * @param hdr 消息头
+ * @return uint16_t 消息长度
+ */
+static uint16_t osal_msg_payload_len(const struct osal_msg_hdr *hdr) {
+  if (hdr->flags & OSAL_MSG_F_REF) {
+    return ((const struct osal_msg_ref *)hdr)->msg->len;
+  }
+  return hdr->len;
+}
+
+/**
+ * @brief 释放一个队列节点，广播消息的引用节点会同时释放对被引用消息的引用
+ *
+ * @param hdr 消息头
+ */
+static void osal_msg_release(struct osal_msg_hdr *hdr) {
+  if (hdr->flags & OSAL_MSG_F_REF) {
+    struct osal_msg_hdr *msg = ((struct osal_msg_ref *)hdr)->msg;
+    osal_mem_free(hdr);
+    hdr = msg;
+  }
+  osal_msg_deallocate(OSAL_MSG_BUFFER(hdr));
+}
+
+/**
+ * @brief 判断任务的消息队列是否放不下len字节的新消息，调用者需处于临界区
+ *
  * @param task 任务指针
- * @param msg 消息指针
+ * @param len 新消息长度
+ * @return true 队列已满
  */
-uint8_t osal_send_msg(struct osal_tcb *task, uint8_t *buf, uint16_t len) {
-  struct osal_msg_hdr *msg = osal_msg_allocate(len);
-  if (msg) {
-    memcpy(OSAL_MSG_BUFFER(msg), buf, len);
-    hal_reg_t cpu_sr = hal_enter_critical();
-    struct osal_msg_hdr *ptr = task->msg_list;
-    if(ptr == NULL) {
-      task->msg_list = msg;
+static bool osal_msg_full(const struct osal_tcb *task, uint16_t len) {
+  return ((task->msg_max_cnt != 0) && (task->msg_cnt >= task->msg_max_cnt)) ||
+         ((task->msg_max_bytes != 0) &&
+          (task->msg_bytes + len > task->msg_max_bytes));
+}
+
+/**
+ * @brief 判断丢弃prio及更低优先级通道中的旧消息后能否放下新消息，调用者需处于临界区
+ * 按丢弃的顺序模拟，只访问会被丢弃的消息
+ *
+ * @param task 任务指针
+ * @param prio 新消息的优先级通道
+ * @param len 新消息长度
+ * @return true 丢弃旧消息可以腾出空间
+ */
+static bool osal_msg_can_evict(const struct osal_tcb *task, uint8_t prio,
+                               uint16_t len) {
+  // 新消息超过队列容量，丢弃再多旧消息也放不下
+  if ((task->msg_max_bytes != 0) && (len > task->msg_max_bytes)) {
+    return false;
+  }
+
+  uint16_t cnt = task->msg_cnt;
+  uint32_t bytes = task->msg_bytes;
+  for (uint8_t lane = 0; lane <= prio; lane++) {
+    for (const struct osal_msg_hdr *old = task->msg_head[lane]; old != NULL;
+         old = old->next) {
+      if (old->flags & OSAL_MSG_F_NODROP) {
+        continue;
+      }
+      cnt--;
+      bytes -= osal_msg_payload_len(old);
+      if (((task->msg_max_cnt == 0) || (cnt < task->msg_max_cnt)) &&
+          ((task->msg_max_bytes == 0) ||
+           (bytes + len <= task->msg_max_bytes))) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief 从任务消息队列指定优先级通道的头部取出一个节点，调用者需处于临界区
+ *
+ * @param task 任务指针
+ * @param prio 优先级通道
+ * @return struct osal_msg_hdr* 消息头，通道为空时返回NULL
+ */
+static struct osal_msg_hdr *osal_msg_dequeue_lane(struct osal_tcb *task,
+                                                  uint8_t prio) {
+  struct osal_msg_hdr *hdr = task->msg_head[prio];
+  if (hdr != NULL) {
+    task->msg_head[prio] = hdr->next;
+    if (task->msg_head[prio] == NULL) {
+      task->msg_tail[prio] = NULL;
+    }
+    hdr->next = NULL;
+    hdr->flags &= (uint8_t)~OSAL_MSG_F_NODROP;
+    task->msg_cnt--;
+    task->msg_bytes -= osal_msg_payload_len(hdr);
+  }
+  return hdr;
+}
+
+/**
+ * @brief 从任务消息队列指定优先级通道中取出最早的可丢弃消息，调用者需处于临界区
+ * 跳过带OSAL_MSG_F_NODROP标志的消息
+ *
+ * @param task 任务指针
+ * @param prio 优先级通道
+ * @return struct osal_msg_hdr* 消息头，没有可丢弃的消息时返回NULL
+ */
+static struct osal_msg_hdr *osal_msg_evict_lane(struct osal_tcb *task,
+                                                uint8_t prio) {
+  struct osal_msg_hdr *prev = NULL;
+  for (struct osal_msg_hdr *hdr = task->msg_head[prio]; hdr != NULL;
+       prev = hdr, hdr = hdr->next) {
+    if (hdr->flags & OSAL_MSG_F_NODROP) {
+      continue;
+    }
+    if (prev == NULL) {
+      task->msg_head[prio] = hdr->next;
     } else {
-      while(ptr->next != NULL) {
-        ptr = ptr->next;
+      prev->next = hdr->next;
+    }
+    if (task->msg_tail[prio] == hdr) {
+      task->msg_tail[prio] = prev;
+    }
+    hdr->next = NULL;
+    task->msg_cnt--;
+    task->msg_bytes -= osal_msg_payload_len(hdr);
+    return hdr;
+  }
+  return NULL;
+}
+
+/**
+ * @brief 从任务消息队列中取出优先级最高的通道头部的节点，调用者需处于临界区
+ *
+ * @param task 任务指针
+ * @return struct osal_msg_hdr* 消息头，队列为空时返回NULL
+ */
+static struct osal_msg_hdr *osal_msg_dequeue(struct osal_tcb *task) {
+  for (uint8_t prio = OSAL_MSG_LANES; prio-- > 0;) {
+    if (task->msg_head[prio] != NULL) {
+      return osal_msg_dequeue_lane(task, prio);
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief 将消息放到任务消息队列的尾部，并置位任务的消息事件
+ * 队列已满时按任务的处理策略处理：
+ * OSAL_MSG_POLICY_REJECT：不放入队列，返回OSAL_MSG_QUEUE_FULL，消息仍归调用者所有
+ * OSAL_MSG_POLICY_DROP_OLDEST：从低优先级通道开始丢弃旧消息，放入新消息，返回OSAL_MSG_DROPPED，
+ * 不会为了低优先级的新消息丢弃高优先级的旧消息，丢弃旧消息也放不下时只丢弃新消息
+ * OSAL_MSG_POLICY_DROP_NEWEST：丢弃新消息，返回OSAL_MSG_DROPPED
+ * 带OSAL_MSG_F_NODROP标志的新消息放不下时按OSAL_MSG_POLICY_REJECT处理，
+ * 队列中带此标志的旧消息不会被丢弃
+ *
+ * @param task 任务指针
+ * @param hdr 消息头
+ * @return uint8_t OSAL_OK和OSAL_MSG_DROPPED表示消息已被队列接管
+ */
+static uint8_t osal_msg_enqueue(struct osal_tcb *task,
+                                struct osal_msg_hdr *hdr) {
+  const uint16_t len = osal_msg_payload_len(hdr);
+  const uint8_t prio = OSAL_MSG_PRIO(hdr);
+  const bool nodrop = (hdr->flags & OSAL_MSG_F_NODROP) != 0;
+  struct osal_msg_hdr *dropped = NULL; // 被丢弃的旧消息，退出临界区后释放
+  uint8_t ret = OSAL_OK;
+
+  OSAL_TASK_CTX_CHECK(task);
+  hdr->next = NULL;
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  if (osal_msg_full(task, len)) {
+    if ((task->msg_policy == OSAL_MSG_POLICY_DROP_OLDEST) &&
+        osal_msg_can_evict(task, prio, len)) {
+      for (uint8_t lane = 0; lane <= prio; lane++) {
+        while (osal_msg_full(task, len)) {
+          struct osal_msg_hdr *old = osal_msg_evict_lane(task, lane);
+          if (old == NULL) {
+            break;
+          }
+          old->next = dropped;
+          dropped = old;
+          task->msg_dropped++;
+        }
       }
-      ptr->next = msg;
+      ret = OSAL_MSG_DROPPED;
     }
-    hal_exit_critical(cpu_sr);
+
+    // 不能或没有丢弃旧消息，按策略拒绝或丢弃新消息
+    if (osal_msg_full(task, len)) {
+      if ((task->msg_policy == OSAL_MSG_POLICY_REJECT) || nodrop) {
+        ret = OSAL_MSG_QUEUE_FULL;
+      } else {
+        task->msg_dropped++;
+        ret = OSAL_MSG_DROPPED;
+      }
+      hal_exit_critical(cpu_sr);
+
+      if (ret == OSAL_MSG_DROPPED) {
+        osal_msg_release(hdr);
+      }
+      while (dropped != NULL) {
+        struct osal_msg_hdr *next = dropped->next;
+        osal_msg_release(dropped);
+        dropped = next;
+      }
+      return ret;
+    }
+  }
+
+  if (task->msg_tail[prio] == NULL) {
+    task->msg_head[prio] = hdr;
+  } else {
+    task->msg_tail[prio]->next = hdr;
+  }
+  task->msg_tail[prio] = hdr;
+  task->msg_cnt++;
+  task->msg_bytes += len;
+  task->events |= OSAL_SYS_EVENT_MSG;
+  osal_task_signal(task);
+  hal_exit_critical(cpu_sr);
+
+  while (dropped != NULL) {
+    struct osal_msg_hdr *next = dropped->next;
+    osal_msg_release(dropped);
+    dropped = next;
+  }
+  return ret;
+}
+
+/**
+ * @brief 将一串按next链接的消息按顺序放到任务的消息队列中
+ * 任务消息队列不限制容量时，先在临界区外按优先级通道分组，再在一个临界区中整体接入；
+ * 否则逐条按osal_msg_enqueue处理，遇到OSAL_MSG_QUEUE_FULL时停止
+ *
+ * @param task 任务指针
+ * @param list 消息链表
+ * @return struct osal_msg_hdr* 没有放入队列的剩余消息，全部放入时返回NULL
+ */
+static struct osal_msg_hdr *osal_msg_enqueue_list(struct osal_tcb *task,
+                                                  struct osal_msg_hdr *list) {
+  hal_reg_t cpu_sr = hal_enter_critical();
+  bool bounded = (task->msg_max_cnt != 0) || (task->msg_max_bytes != 0);
+  hal_exit_critical(cpu_sr);
+
+  if (bounded) {
+    while (list != NULL) {
+      struct osal_msg_hdr *next = list->next;
+      if (osal_msg_enqueue(task, list) == OSAL_MSG_QUEUE_FULL) {
+        list->next = next;
+        return list;
+      }
+      list = next;
+    }
+    return NULL;
+  }
+
+  struct osal_msg_hdr *head[OSAL_MSG_LANES] = {NULL};
+  struct osal_msg_hdr *tail[OSAL_MSG_LANES] = {NULL};
+  uint16_t cnt = 0;
+  uint32_t bytes = 0;
+
+  while (list != NULL) {
+    struct osal_msg_hdr *next = list->next;
+    uint8_t prio = OSAL_MSG_PRIO(list);
+    list->next = NULL;
+    if (tail[prio] == NULL) {
+      head[prio] = list;
+    } else {
+      tail[prio]->next = list;
+    }
+    tail[prio] = list;
+    cnt++;
+    bytes += osal_msg_payload_len(list);
+    list = next;
+  }
+
+  if (cnt == 0) {
+    return NULL;
   }
-}
\ No newline at end of file
+
+  cpu_sr = hal_enter_critical();
+  for (uint8_t prio = 0; prio < OSAL_MSG_LANES; prio++) {
+    if (head[prio] == NULL) {
+      continue;
+    }
+    if (task->msg_tail[prio] == NULL) {
+      task->msg_head[prio] = head[prio];
+    } else {
+      task->msg_tail[prio]->next = head[prio];
+    }
+    task->msg_tail[prio] = tail[prio];
+  }
+  task->msg_cnt += cnt;
+  task->msg_bytes += bytes;
+  task->events |= OSAL_SYS_EVENT_MSG;
+  osal_task_signal(task);
+  hal_exit_critical(cpu_sr);
+
+  return NULL;
+}
+
+/**
+ * @brief 将多段数据拷贝到一个新消息缓冲区中，放到任务消息队列指定优先级通道的尾部
+ * 队列已满且不丢弃旧消息时不会申请缓冲区
+ *
+ * @param task 任务指针
+ * @param iov 数据段数组
+ * @param cnt 数据段数量
+ * @param prio 优先级通道
+ * @return uint8_t 成功返回OSAL_OK，消息长度为0返回OSAL_MSG_EMPTY，
+ * 超过OSAL_MSG_LEN_MAX返回OSAL_MSG_TOO_LONG
+ */
+static uint8_t osal_msg_send_gather(struct osal_tcb *task,
+                                    const struct osal_iovec *iov, uint8_t cnt,
+                                    uint8_t prio) {
+  if (task == NULL) {
+    return OSAL_INVALID_TASK;
+  }
+  if ((iov == NULL) && (cnt != 0)) {
+    return OSAL_INVALID_MSG_POINTER;
+  }
+
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < cnt; i++) {
+    total += iov[i].len;
+  }
+  if (total == 0) {
+    return OSAL_MSG_EMPTY;
+  }
+  if (total > OSAL_MSG_LEN_MAX) {
+    return OSAL_MSG_TOO_LONG;
+  }
+  const uint16_t len = (uint16_t)total;
+
+  // 队列已满时先拒绝，避免消费慢的任务耗尽内存
+  hal_reg_t cpu_sr = hal_enter_critical();
+  if (osal_msg_full(task, len) &&
+      (task->msg_policy != OSAL_MSG_POLICY_DROP_OLDEST)) {
+    uint8_t ret = OSAL_MSG_QUEUE_FULL;
+    if (task->msg_policy == OSAL_MSG_POLICY_DROP_NEWEST) {
+      task->msg_dropped++;
+      ret = OSAL_MSG_DROPPED;
+    }
+    hal_exit_critical(cpu_sr);
+    return ret;
+  }
+  hal_exit_critical(cpu_sr);
+
+  uint8_t *msg = osal_msg_allocate(len);
+  if (msg == NULL) {
+    return OSAL_MSG_BUFFER_NOT_AVAIL;
+  }
+
+  uint8_t *dst = msg;
+  for (uint8_t i = 0; i < cnt; i++) {
+    if (iov[i].len) {
+      memcpy(dst, iov[i].base, iov[i].len);
+      dst += iov[i].len;
+    }
+  }
+
+  osal_msg_set_prio(msg, prio);
+  uint8_t ret = osal_msg_enqueue(task, OSAL_MSG_HDR(msg));
+  if (ret == OSAL_MSG_QUEUE_FULL) {
+    osal_msg_deallocate(msg);
+  }
+  return ret;
+}
+
+/**
+ * @brief 将消息放到任务的消息队列尾部，并置位任务的OSAL_SYS_EVENT_MSG事件
+ * 此函数会将buf中的数据拷贝到一个新消息缓冲区中，调用完此函数后buf可以被释放了。
+ * 新的消息缓冲区由消息消费端调用osal_msg_deallocate释放。
+ * 队列已满且不丢弃旧消息时不会申请缓冲区。
+ *
+ * @param task 任务指针
+ * @param buf 消息数据
+ * @param len 消息长度
+ * @return uint8_t 成功返回OSAL_OK，队列已满返回OSAL_MSG_QUEUE_FULL或OSAL_MSG_DROPPED
+ */
+uint8_t osal_send_msg(struct osal_tcb *task, const uint8_t *buf, uint16_t len) {
+  return osal_send_msg_prio(task, buf, len, OSAL_MSG_PRIO_NORMAL);
+}
+
+/**
+ * @brief 将消息放到任务消息队列指定优先级通道的尾部，其他同osal_send_msg
+ * 接收任务总是先取出高优先级通道中的消息
+ *
+ * @param task 任务指针
+ * @param buf 消息数据
+ * @param len 消息长度
+ * @param prio 优先级通道，0~OSAL_MSG_LANES-1，越大越优先
+ * @return uint8_t 成功返回OSAL_OK，队列已满返回OSAL_MSG_QUEUE_FULL或OSAL_MSG_DROPPED
+ */
+uint8_t osal_send_msg_prio(struct osal_tcb *task, const uint8_t *buf,
+                           uint16_t len, uint8_t prio) {
+  const struct osal_iovec iov = {buf, len};
+  return osal_msg_send_gather(task, &iov, 1, prio);
+}
+
+/**
+ * @brief 将多段数据依次拷贝到一个新消息缓冲区中，放到任务的消息队列尾部，其他同osal_send_msg
+ * 只申请一次缓冲区、拷贝一次数据，发送端不需要先拼接成连续的临时缓冲区
+ *
+ * @param task 任务指针
+ * @param iov 数据段数组
+ * @param cnt 数据段数量
+ * @return uint8_t 成功返回OSAL_OK，消息总长度超出消息缓冲区上限返回OSAL_MSG_TOO_LONG，
+ * 总长度为0返回OSAL_MSG_EMPTY
+ */
+uint8_t osal_send_msgv(struct osal_tcb *task, const struct osal_iovec *iov,
+                       uint8_t cnt) {
+  return osal_msg_send_gather(task, iov, cnt, OSAL_MSG_PRIO_NORMAL);
+}
+
+/**
+ * @brief 将osal_msg_allocate申请的消息缓冲区直接放到任务的消息队列尾部，不拷贝数据
+ * 调用后消息缓冲区的所有权转移给接收任务，发送端不能再访问或释放该缓冲区。
+ * 任务无效时缓冲区会被释放；返回OSAL_MSG_QUEUE_FULL时缓冲区仍归发送端所有，可以稍后重发
+ *
+ * @param task 任务指针
+ * @param msg 消息缓冲区指针
+ * @return uint8_t 成功返回OSAL_OK
+ */
+uint8_t osal_msg_send_owned(struct osal_tcb *task, uint8_t *msg) {
+  if (msg == NULL) {
+    return OSAL_INVALID_MSG_POINTER;
+  }
+
+  if (task == NULL) {
+    osal_msg_deallocate(msg);
+    return OSAL_INVALID_TASK;
+  }
+
+  return osal_msg_enqueue(task, OSAL_MSG_HDR(msg));
+}
+
+/**
+ * @brief 与osal_msg_send_owned相同，但新消息放不下时不会被丢弃，返回OSAL_MSG_QUEUE_FULL，
+ * 放入队列后也不会因为之后发送的消息被丢弃
+ *
+ * @param task 任务指针
+ * @param msg 消息缓冲区指针
+ * @return uint8_t 成功返回OSAL_OK，丢弃了旧消息时返回OSAL_MSG_DROPPED
+ */
+uint8_t osal_msg_send_nodrop(struct osal_tcb *task, uint8_t *msg) {
+  if (msg == NULL) {
+    return OSAL_INVALID_MSG_POINTER;
+  }
+
+  if (task == NULL) {
+    osal_msg_deallocate(msg);
+    return OSAL_INVALID_TASK;
+  }
+
+  OSAL_MSG_HDR(msg)->flags |= OSAL_MSG_F_NODROP;
+  return osal_msg_enqueue(task, OSAL_MSG_HDR(msg));
+}
+
+/**
+ * @brief 从任务的消息队列头部取出一条消息
+ * 队列中还有消息时保持OSAL_SYS_EVENT_MSG事件，否则清除该事件
+ *
+ * @param task 任务指针
+ * @return uint8_t* 消息缓冲区指针，队列为空时返回NULL
+ */
+uint8_t *osal_msg_receive(struct osal_tcb *task) {
+  if (task == NULL) {
+    return NULL;
+  }
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  struct osal_msg_hdr *hdr = osal_msg_dequeue(task);
+
+  if (task->msg_cnt != 0) {
+    task->events |= OSAL_SYS_EVENT_MSG;
+    osal_task_signal(task);
+  } else {
+    task->events &= ~OSAL_SYS_EVENT_MSG;
+  }
+  hal_exit_critical(cpu_sr);
+
+  // 广播消息的引用节点，释放引用节点，返回被引用的消息
+  if (hdr && (hdr->flags & OSAL_MSG_F_REF)) {
+    struct osal_msg_hdr *msg = ((struct osal_msg_ref *)hdr)->msg;
+    osal_mem_free(hdr);
+    hdr = msg;
+  }
+
+  return hdr ? OSAL_MSG_BUFFER(hdr) : NULL;
+}
+
+/**
+ * @brief 将多个osal_msg_allocate申请的消息缓冲区按顺序放到任务的消息队列中，不拷贝数据
+ * 任务消息队列不限制容量时，所有消息在一个临界区中放入队列。
+ * 已放入队列或被丢弃的消息所有权转移给接收任务；队列已满时停止，
+ * 剩余的消息仍归发送端所有，可以从msgs[返回值]开始重发
+ *
+ * @param task 任务指针
+ * @param msgs 消息缓冲区指针数组
+ * @param cnt 消息数量
+ * @return uint16_t 所有权已转移的消息数量
+ */
+uint16_t osal_msg_send_batch(struct osal_tcb *task, uint8_t *const msgs[],
+                             uint16_t cnt) {
+  if ((task == NULL) || (msgs == NULL)) {
+    return 0;
+  }
+
+  struct osal_msg_hdr *list = NULL;
+  struct osal_msg_hdr **link = &list;
+  uint16_t n = 0;
+  for (; (n < cnt) && (msgs[n] != NULL); n++) {
+    *link = OSAL_MSG_HDR(msgs[n]);
+    link = &(*link)->next;
+  }
+  *link = NULL;
+
+  // 统计没有放入队列的剩余消息
+  for (struct osal_msg_hdr *rest = osal_msg_enqueue_list(task, list);
+       rest != NULL; rest = rest->next) {
+    n--;
+  }
+  return n;
+}
+
+/**
+ * @brief 在一个临界区中取出任务消息队列中的全部消息，并清除OSAL_SYS_EVENT_MSG事件
+ * 消息按优先级从高到低、同一优先级按先后顺序排列，使用osal_msg_next逐条取出，
+ * 取出后的消息和osal_msg_receive得到的一样，需要调用osal_msg_deallocate释放
+ *
+ * @param task 任务指针
+ * @return struct osal_msg_hdr* 消息链，队列为空时返回NULL
+ */
+struct osal_msg_hdr *osal_msg_receive_all(struct osal_tcb *task) {
+  if (task == NULL) {
+    return NULL;
+  }
+
+  struct osal_msg_hdr *chain = NULL;
+  struct osal_msg_hdr *tail = NULL;
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  for (uint8_t prio = OSAL_MSG_LANES; prio-- > 0;) {
+    if (task->msg_head[prio] == NULL) {
+      continue;
+    }
+    if (tail == NULL) {
+      chain = task->msg_head[prio];
+    } else {
+      tail->next = task->msg_head[prio];
+    }
+    tail = task->msg_tail[prio];
+    task->msg_head[prio] = NULL;
+    task->msg_tail[prio] = NULL;
+  }
+  task->msg_cnt = 0;
+  task->msg_bytes = 0;
+  task->events &= ~OSAL_SYS_EVENT_MSG;
+  hal_exit_critical(cpu_sr);
+
+  return chain;
+}
+
+/**
+ * @brief 从osal_msg_receive_all得到的消息链中取出下一条消息，不进入临界区
+ *
+ * @param chain 消息链，取出后指向剩余的消息
+ * @return uint8_t* 消息缓冲区指针，消息链为空时返回NULL
+ */
+uint8_t *osal_msg_next(struct osal_msg_hdr **chain) {
+  if ((chain == NULL) || (*chain == NULL)) {
+    return NULL;
+  }
+
+  struct osal_msg_hdr *hdr = *chain;
+  *chain = hdr->next;
+  hdr->next = NULL;
+  hdr->flags &= (uint8_t)~OSAL_MSG_F_NODROP;
+
+  // 广播消息的引用节点，释放引用节点，返回被引用的消息
+  if (hdr->flags & OSAL_MSG_F_REF) {
+    struct osal_msg_hdr *msg = ((struct osal_msg_ref *)hdr)->msg;
+    osal_mem_free(hdr);
+    hdr = msg;
+  }
+
+  return OSAL_MSG_BUFFER(hdr);
+}
+
+/**
+ * @brief 设置消息的优先级通道，在osal_msg_send_owned、osal_publish等发送之前调用
+ * osal_msg_allocate申请的消息默认为OSAL_MSG_PRIO_NORMAL
+ *
+ * @param msg 消息缓冲区指针
+ * @param prio 优先级通道，超过OSAL_MSG_LANES-1时使用最高优先级通道
+ */
+void osal_msg_set_prio(uint8_t *msg, uint8_t prio) {
+  if (msg == NULL) {
+    return;
+  }
+  if (prio >= OSAL_MSG_LANES) {
+    prio = OSAL_MSG_LANES - 1;
+  }
+
+  struct osal_msg_hdr *hdr = OSAL_MSG_HDR(msg);
+  hdr->flags = (uint8_t)((hdr->flags & ~OSAL_MSG_F_PRIO_MASK) |
+                         (prio << OSAL_MSG_F_PRIO_SHIFT));
+}
+
+/**
+ * @brief 设置任务消息队列的容量和队列已满时的处理策略
+ * 一般在osal_add_task之后立即调用
+ *
+ * @param task 任务指针
+ * @param max_cnt 最多容纳的消息数量，0表示不限制
+ * @param max_bytes 最多容纳的消息字节数，0表示不限制
+ * @param policy 队列已满时的处理策略
+ */
+void osal_msg_set_limit(struct osal_tcb *task, uint16_t max_cnt,
+                        uint32_t max_bytes, uint8_t policy) {
+  if (task == NULL) {
+    return;
+  }
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  task->msg_max_cnt = max_cnt;
+  task->msg_max_bytes = max_bytes;
+  task->msg_policy = policy;
+  hal_exit_critical(cpu_sr);
+}
+
+/**
+ * @brief 获取任务消息队列中的消息数量
+ *
+ * @param task 任务指针
+ * @return uint16_t 消息数量
+ */
+uint16_t osal_msg_count(const struct osal_tcb *task) {
+  return task ? task->msg_cnt : 0;
+}
+
+/**
+ * @brief 获取任务因队列已满而丢弃的消息数量
+ *
+ * @param task 任务指针
+ * @return uint16_t 丢弃的消息数量
+ */
+uint16_t osal_msg_dropped(const struct osal_tcb *task) {
+  return task ? task->msg_dropped : 0;
+}
+
+/**
+ * @brief 查看任务消息队列头部的消息，消息仍保留在队列中
+ *
+ * @param task 任务指针
+ * @return uint8_t* 消息缓冲区指针，队列为空时返回NULL
+ */
+uint8_t *osal_msg_peek(const struct osal_tcb *task) {
+  if (task == NULL) {
+    return NULL;
+  }
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  struct osal_msg_hdr *hdr = NULL;
+  for (uint8_t prio = OSAL_MSG_LANES; (hdr == NULL) && (prio-- > 0);) {
+    hdr = task->msg_head[prio];
+  }
+  if (hdr && (hdr->flags & OSAL_MSG_F_REF)) {
+    hdr = ((struct osal_msg_ref *)hdr)->msg;
+  }
+  hal_exit_critical(cpu_sr);
+
+  return hdr ? OSAL_MSG_BUFFER(hdr) : NULL;
+}
+
+#if OSAL_EVT_RING
+/**
+ * @brief 发送携带少量数据的事件，数据拷贝到任务内部的环形队列中，不申请内存
+ * 发送后置位接收任务的OSAL_SYS_EVENT_DATA事件
+ *
+ * @param task 任务指针
+ * @param tag 事件标签，由应用定义，用于区分数据类型
+ * @param data 事件数据
+ * @param len 数据长度，不能超过OSAL_EVT_DATA_MAX
+ * @return uint8_t 成功返回OSAL_OK，队列已满返回OSAL_MSG_QUEUE_FULL
+ */
+uint8_t osal_send_evt(struct osal_tcb *task, uint8_t tag, const void *data,
+                      uint8_t len) {
+  if (task == NULL) {
+    return OSAL_INVALID_TASK;
+  }
+  if (len > OSAL_EVT_DATA_MAX) {
+    return OSAL_MSG_TOO_LONG;
+  }
+  OSAL_TASK_CTX_CHECK(task);
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  if (task->evt_cnt >= OSAL_EVT_RING) {
+    hal_exit_critical(cpu_sr);
+    return OSAL_MSG_QUEUE_FULL;
+  }
+
+  struct osal_evt *evt =
+      &task->evt_ring[(task->evt_head + task->evt_cnt) % OSAL_EVT_RING];
+  evt->tag = tag;
+  evt->len = len;
+  if (len) {
+    memcpy(evt->data, data, len);
+  }
+  task->evt_cnt++;
+  task->events |= OSAL_SYS_EVENT_DATA;
+  osal_task_signal(task);
+  hal_exit_critical(cpu_sr);
+
+  return OSAL_OK;
+}
+
+/**
+ * @brief 从任务的小数据事件队列头部取出一个事件
+ * 队列中还有事件时保持OSAL_SYS_EVENT_DATA事件，否则清除该事件
+ *
+ * @param task 任务指针
+ * @param tag 返回事件标签，可以为NULL
+ * @param data 返回事件数据，缓冲区至少OSAL_EVT_DATA_MAX字节，可以为NULL
+ * @return int16_t 数据长度，队列为空时返回-1
+ */
+int16_t osal_evt_receive(struct osal_tcb *task, uint8_t *tag, void *data) {
+  int16_t len = -1;
+
+  if (task == NULL) {
+    return len;
+  }
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  if (task->evt_cnt > 0) {
+    struct osal_evt *evt = &task->evt_ring[task->evt_head];
+    if (tag) {
+      *tag = evt->tag;
+    }
+    if (data && evt->len) {
+      memcpy(data, evt->data, evt->len);
+    }
+    len = evt->len;
+    task->evt_head = (uint8_t)((task->evt_head + 1) % OSAL_EVT_RING);
+    task->evt_cnt--;
+  }
+
+  if (task->evt_cnt > 0) {
+    task->events |= OSAL_SYS_EVENT_DATA;
+    osal_task_signal(task);
+  } else {
+    task->events &= ~OSAL_SYS_EVENT_DATA;
+  }
+  hal_exit_critical(cpu_sr);
+
+  return len;
+}
+#endif
+
+/**
+ * @brief 任务订阅主题，之后发布到该主题的消息都会放到任务的消息队列中
+ *
+ * @param task 任务指针
+ * @param topic 主题
+ * @return uint8_t 成功或已经订阅过返回OSAL_OK
+ */
+uint8_t osal_subscribe(struct osal_tcb *task, uint8_t topic) {
+  if (task == NULL) {
+    return OSAL_INVALID_TASK;
+  }
+  if (topic >= OSAL_MAX_TOPICS) {
+    return OSAL_INVALID_TOPIC;
+  }
+
+  struct osal_topic_sub *sub = osal_mem_alloc(sizeof(struct osal_topic_sub));
+  if (sub == NULL) {
+    return OSAL_MSG_BUFFER_NOT_AVAIL;
+  }
+  sub->task = task;
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  for (struct osal_topic_sub *old = topic_subs[topic]; old != NULL;
+       old = old->next) {
+    // 已经订阅过
+    if (old->task == task) {
+      hal_exit_critical(cpu_sr);
+      osal_mem_free(sub);
+      return OSAL_OK;
+    }
+  }
+  sub->next = topic_subs[topic];
+  topic_subs[topic] = sub;
+  hal_exit_critical(cpu_sr);
+
+  return OSAL_OK;
+}
+
+/**
+ * @brief 任务取消订阅主题
+ *
+ * @param task 任务指针
+ * @param topic 主题
+ * @return uint8_t 成功返回OSAL_OK
+ */
+uint8_t osal_unsubscribe(struct osal_tcb *task, uint8_t topic) {
+  if (topic >= OSAL_MAX_TOPICS) {
+    return OSAL_INVALID_TOPIC;
+  }
+
+  struct osal_topic_sub *found = NULL;
+
+  hal_reg_t cpu_sr = hal_enter_critical();
+  for (struct osal_topic_sub **sub_ptr = &topic_subs[topic]; *sub_ptr != NULL;
+       sub_ptr = &(*sub_ptr)->next) {
+    if ((*sub_ptr)->task == task) {
+      found = *sub_ptr;
+      *sub_ptr = found->next;
+      break;
+    }
+  }
+  hal_exit_critical(cpu_sr);
+
+  if (found == NULL) {
+    return OSAL_INVALID_TASK;
+  }
+  osal_mem_free(found);
+  return OSAL_OK;
+}
+
+/**
+ * @brief 将osal_msg_allocate申请的消息发布到主题，所有订阅任务共享同一个消息缓冲区
+ * 第一个订阅任务直接接收该消息，其他订阅任务接收一个引用节点，不拷贝数据。
+ * 接收任务只能读取广播消息，最后一个接收任务调用osal_msg_deallocate后释放缓冲区。
+ * 调用后消息缓冲区的所有权转移给订阅任务，没有订阅任务或全部订阅任务队列已满时缓冲区会被释放
+ *
+ * @param topic 主题
+ * @param msg 消息缓冲区指针
+ * @return uint8_t 全部订阅任务都收到消息时返回OSAL_OK，否则返回最后一个失败原因
+ */
+uint8_t osal_publish(uint8_t topic, uint8_t *msg) {
+  if (msg == NULL) {
+    return OSAL_INVALID_MSG_POINTER;
+  }
+  if (topic >= OSAL_MAX_TOPICS) {
+    osal_msg_deallocate(msg);
+    return OSAL_INVALID_TOPIC;
+  }
+
+  struct osal_msg_hdr *hdr = OSAL_MSG_HDR(msg);
+  struct osal_msg_ref *refs = NULL; // 待发送的引用节点，通过hdr.next串起来
+  struct osal_tcb *first = NULL;
+  uint8_t ref = 0;
+  uint8_t ret = OSAL_OK;
+
+  // 先为每个订阅任务准备好节点，设置好引用计数后再放入队列，
+  // 避免接收任务提前释放消息
+  hal_reg_t cpu_sr = hal_enter_critical();
+  for (struct osal_topic_sub *sub = topic_subs[topic]; sub != NULL;
+       sub = sub->next) {
+    if (first == NULL) {
+      first = sub->task;
+      ref++;
+      continue;
+    }
+
+    struct osal_msg_ref *node = osal_mem_alloc(sizeof(struct osal_msg_ref));
+    if (node == NULL) {
+      ret = OSAL_MSG_BUFFER_NOT_AVAIL;
+      continue;
+    }
+    node->hdr.len = 0;
+    node->hdr.ref = 1;
+    node->hdr.flags = OSAL_MSG_F_REF | (hdr->flags & OSAL_MSG_F_PRIO_MASK);
+    node->hdr.next = (struct osal_msg_hdr *)refs;
+    node->msg = (struct osal_msg_hdr *)sub->task; // 暂存接收任务
+    refs = node;
+    ref++;
+  }
+  hal_exit_critical(cpu_sr);
+
+  if (first == NULL) {
+    osal_mem_free(hdr);
+    return ret;
+  }
+
+  hdr->ref = ref;
+
+  // 队列已满被拒绝的节点需要释放对消息的引用
+  while (refs != NULL) {
+    struct osal_msg_ref *node = refs;
+    struct osal_tcb *task = (struct osal_tcb *)node->msg;
+    refs = (struct osal_msg_ref *)node->hdr.next;
+    node->msg = hdr;
+    uint8_t status = osal_msg_enqueue(task, &node->hdr);
+    if (status == OSAL_MSG_QUEUE_FULL) {
+      osal_msg_release(&node->hdr);
+    }
+    if (status != OSAL_OK) {
+      ret = status;
+    }
+  }
+
+  uint8_t status = osal_msg_enqueue(first, hdr);
+  if (status == OSAL_MSG_QUEUE_FULL) {
+    osal_msg_deallocate(msg);
+  }
+  if (status != OSAL_OK) {
+    ret = status;
+  }
+
+  return ret;
+}
+
+#if OSAL_MSG_MPSC
+/**
+ * @brief 从其他线程向任务投递osal_msg_allocate申请的消息缓冲区，不进入临界区
+ * 消息先放入任务的无锁收件箱，osal在下一次调度前按发送顺序移入任务消息队列。
+ * 移入时队列已满，按OSAL_MSG_POLICY_DROP_NEWEST处理，发送端不会收到OSAL_MSG_QUEUE_FULL
+ * 多实例时投递线程必须绑定到任务所属的实例
+ *
+ * @param task 任务指针
+ * @param msg 消息缓冲区指针
+ * @return uint8_t 成功返回OSAL_OK
+ */
+uint8_t osal_msg_post(struct osal_tcb *task, uint8_t *msg) {
+  if (msg == NULL) {
+    return OSAL_INVALID_MSG_POINTER;
+  }
+
+  if (task == NULL) {
+    osal_msg_deallocate(msg);
+    return OSAL_INVALID_TASK;
+  }
+  OSAL_TASK_CTX_CHECK(task);
+
+  // 只有消费端会一次取走整个收件箱，压栈不存在ABA问题
+  struct osal_msg_hdr *hdr = OSAL_MSG_HDR(msg);
+  struct osal_msg_hdr *head =
+      atomic_load_explicit(&task->inbox, memory_order_relaxed);
+  do {
+    hdr->next = head;
+  } while (!atomic_compare_exchange_weak_explicit(
+      &task->inbox, &head, hdr, memory_order_release, memory_order_relaxed));
+
+  atomic_store_explicit(&OSAL_TASK_INBOX_PENDING(task), true,
+                        memory_order_release);
+#if OSAL_WORKERS
+  osal_worker_wake();
+#endif
+  return OSAL_OK;
+}
+
+/**
+ * @brief 从其他线程置位任务的事件，不进入临界区，osal在下一次调度前合并到任务事件中
+ * 只访问任务自身和所属实例的收件箱标志，可以跨实例调用
+ *
+ * @param task 任务指针
+ * @param event_flag 期望设置的事件
+ */
+void osal_event_post(struct osal_tcb *task, osal_event_t event_flag) {
+  if (task && event_flag) {
+    atomic_fetch_or_explicit(&task->post_events, event_flag,
+                             memory_order_release);
+    atomic_store_explicit(&OSAL_TASK_INBOX_PENDING(task), true,
+                          memory_order_release);
+#if OSAL_WORKERS
+    osal_worker_wake();
+#endif
+  }
+}
+
+/**
+ * @brief 取出所有任务收件箱中的消息和投递的事件，放入任务的消息队列和事件中
+ * 只在osal主循环中调用
+ *
+ */
+static void osal_msg_inbox_drain(void) {
+  for (struct osal_tcb *task = task_list_head; task != NULL;
+       task = task->next) {
+    osal_event_t events = atomic_exchange_explicit(&task->post_events, 0,
+                                               memory_order_acquire);
+    if (events) {
+      osal_set_event(task, events);
+    }
+
+    struct osal_msg_hdr *hdr =
+        atomic_exchange_explicit(&task->inbox, NULL, memory_order_acquire);
+    if (hdr == NULL) {
+      continue;
+    }
+
+    // 收件箱是后进先出，先反转为发送顺序
+    struct osal_msg_hdr *fifo = NULL;
+    while (hdr != NULL) {
+      struct osal_msg_hdr *next = hdr->next;
+      hdr->next = fifo;
+      fifo = hdr;
+      hdr = next;
+    }
+
+    // 发送端已经返回，放不下的消息无法再拒绝，只能丢弃
+    fifo = osal_msg_enqueue_list(task, fifo);
+    while (fifo != NULL) {
+      struct osal_msg_hdr *next = fifo->next;
+      if (osal_msg_enqueue(task, fifo) == OSAL_MSG_QUEUE_FULL) {
+        hal_reg_t cpu_sr = hal_enter_critical();
+        task->msg_dropped++;
+        hal_exit_critical(cpu_sr);
+        osal_msg_release(fifo);
+      }
+      fifo = next;
+    }
+  }
+}
+#endif
+
+#if OSAL_WORKERS
+/**
+ * @brief 唤醒一个空闲的工作线程
+ *
+ */
+static void osal_worker_wake(void) {
+  if (atomic_load(&idle_cnt) != 0) {
+    pthread_mutex_lock(&idle_lock);
+    pthread_cond_signal(&idle_cond);
+    pthread_mutex_unlock(&idle_lock);
+  }
+}
+
+/**
+ * @brief 任务有新事件时放入工作线程的就绪队列，调用者需处于临界区
+ * 正在执行或已在就绪队列中的任务不重复放入，执行完后由工作线程重新检查事件
+ *
+ * @param task 任务指针
+ */
+static void osal_task_signal(struct osal_tcb *task) {
+  if (!workers_started || (task->events == 0) ||
+      (task->sched_state != OSAL_TASK_IDLE)) {
+    return;
+  }
+
+  struct osal_worker *worker = &workers[task->worker];
+  task->sched_state = OSAL_TASK_QUEUED;
+
+  pthread_mutex_lock(&worker->lock);
+  struct osal_tcb **link = &worker->ready;
+  while ((*link != NULL) && ((*link)->priority >= task->priority)) {
+    link = &(*link)->ready_next;
+  }
+  task->ready_next = *link;
+  *link = task;
+  pthread_mutex_unlock(&worker->lock);
+
+  osal_worker_wake();
+}
+
+/**
+ * @brief 取出优先级最高的就绪任务，优先级相同时先取自己队列中的任务，
+ * 否则从其他工作线程的就绪队列中窃取
+ *
+ * @param self 当前工作线程编号
+ * @return struct osal_tcb* 就绪任务，没有时返回NULL
+ */
+static struct osal_tcb *osal_worker_next(uint8_t self) {
+  struct osal_worker *best = NULL;
+  uint8_t best_priority = 0;
+
+  for (uint8_t i = 0; i < OSAL_WORKERS; i++) {
+    struct osal_worker *worker = &workers[(self + i) % OSAL_WORKERS];
+    pthread_mutex_lock(&worker->lock);
+    if ((worker->ready != NULL) &&
+        ((best == NULL) || (worker->ready->priority > best_priority))) {
+      best = worker;
+      best_priority = worker->ready->priority;
+    }
+    pthread_mutex_unlock(&worker->lock);
+  }
+
+  if (best == NULL) {
+    return NULL;
+  }
+
+  // 检查后队首可能已被其他工作线程取走，取到的仍是该队列中优先级最高的任务
+  pthread_mutex_lock(&best->lock);
+  struct osal_tcb *task = best->ready;
+  if (task != NULL) {
+    best->ready = task->ready_next;
+    task->ready_next = NULL;
+  }
+  pthread_mutex_unlock(&best->lock);
+  return task;
+}
+
+/**
+ * @brief 是否有工作需要处理，调用者需持有idle_lock
+ *
+ * @return true 有就绪任务或待取出的收件箱
+ */
+static bool osal_worker_has_work(void) {
+#if OSAL_MSG_MPSC
+  if (atomic_load(&inbox_pending)) {
+    return true;
+  }
+#endif
+  for (uint8_t i = 0; i < OSAL_WORKERS; i++) {
+    pthread_mutex_lock(&workers[i].lock);
+    bool ready = (workers[i].ready != NULL);
+    pthread_mutex_unlock(&workers[i].lock);
+    if (ready) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief 在当前工作线程中执行任务的事件处理函数
+ *
+ * @param task 任务指针
+ * @param self 当前工作线程编号
+ */
+static void osal_worker_run(struct osal_tcb *task, uint8_t self) {
+  // 取出本次要处理的事件标志
+  hal_reg_t cpu_sr = hal_enter_critical();
+  task->sched_state = OSAL_TASK_RUNNING;
+  osal_event_t events = osal_task_take_events(task);
+  hal_exit_critical(cpu_sr);
+
+  // 执行任务处理函数，返回需要再次置位的事件标志
+  if (events != 0) {
+    current_task = task;
+    events = osal_task_dispatch(task, events);
+    current_task = NULL;
+  }
+
+  // 执行期间产生的事件和返回的事件，使任务重新就绪，之后优先在当前线程执行
+  cpu_sr = hal_enter_critical();
+  task->events |= events;
+  task->sched_state = OSAL_TASK_IDLE;
+  task->worker = self;
+  osal_task_signal(task);
+  hal_exit_critical(cpu_sr);
+}
+
+/**
+ * @brief 工作线程主循环
+ *
+ * @param arg 工作线程编号
+ * @return void* 不会返回
+ */
+static void *osal_worker_main(void *arg) {
+  const uint8_t self = (uint8_t)(uintptr_t)arg;
+
+  while (1) {
+#if OSAL_MSG_MPSC
+    // 同一时间只允许一个线程取出收件箱，保证消息顺序
+    if (pthread_mutex_trylock(&inbox_lock) == 0) {
+      if (atomic_exchange_explicit(&inbox_pending, false,
+                                   memory_order_acquire)) {
+        osal_msg_inbox_drain();
+      }
+      pthread_mutex_unlock(&inbox_lock);
+    }
+#endif
+
+    struct osal_tcb *task = osal_worker_next(self);
+    if (task != NULL) {
+      osal_worker_run(task, self);
+#if OSALMEM_DEFERRED_FREE
+      // 批量回收中断或其他线程延迟释放的内存
+      osal_mem_drain();
+#endif
+      continue;
+    }
+
+#if OSALMEM_HANDLE
+    // 没有就绪任务时整理内存碎片
+    if (self == 0) {
+      osal_mem_compact();
+    }
+#endif
+
+    // 没有就绪任务时等待唤醒，超时后再检查一次，避免遗漏
+    pthread_mutex_lock(&idle_lock);
+    atomic_fetch_add(&idle_cnt, 1);
+    if (!osal_worker_has_work()) {
+      struct timespec ts;
+      clock_gettime(CLOCK_REALTIME, &ts);
+      ts.tv_nsec += OSAL_WORKER_IDLE_NS;
+      if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+      }
+      pthread_cond_timedwait(&idle_cond, &idle_lock, &ts);
+    }
+    atomic_fetch_sub(&idle_cnt, 1);
+    pthread_mutex_unlock(&idle_lock);
+  }
+  return NULL;
+}
+
+/**
+ * @brief 启动工作线程调度任务，当前线程作为0号工作线程，此函数不会返回
+ * 由osal_run调用
+ *
+ */
+void osal_task_run_workers(void) {
+  for (uint8_t i = 0; i < OSAL_WORKERS; i++) {
+    pthread_mutex_init(&workers[i].lock, NULL);
+    workers[i].ready = NULL;
+  }
+
+  // 启动前已经产生的事件
+  hal_reg_t cpu_sr = hal_enter_critical();
+  workers_started = true;
+  for (struct osal_tcb *task = task_list_head; task != NULL;
+       task = task->next) {
+    osal_task_signal(task);
+  }
+  hal_exit_critical(cpu_sr);
+
+  for (uint8_t i = 1; i < OSAL_WORKERS; i++) {
+    if (pthread_create(&workers[i].thread, NULL, osal_worker_main,
+                       (void *)(uintptr_t)i) != 0) {
+      perror("Create osal worker error");
+      exit(1);
+    }
+  }
+
+  osal_worker_main((void *)(uintptr_t)0);
+}
+#endif
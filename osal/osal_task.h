@@ -10,8 +10,70 @@
  */
 #pragma once
 
+#include "osal_config.h"
 #include "osal_types.h"
 
+// 工作线程数量，大于0时osal_run使用多个线程并行执行不同任务，同一任务仍然只在一个线程中执行，
+// 只能用于支持pthread的平台
+#ifndef OSAL_WORKERS
+#define OSAL_WORKERS 0
+#endif
+
+// 任务事件位宽，可选16、32、64，最高的几位保留给系统事件
+#ifndef OSAL_EVENT_BITS
+#define OSAL_EVENT_BITS 16
+#endif
+
+// 任务事件标志
+#if OSAL_EVENT_BITS == 16
+typedef uint16_t osal_event_t;
+#elif OSAL_EVENT_BITS == 32
+typedef uint32_t osal_event_t;
+#elif OSAL_EVENT_BITS == 64
+typedef uint64_t osal_event_t;
+#else
+#error "OSAL_EVENT_BITS must be 16, 32 or 64"
+#endif
+
+// 平台是否支持C11无锁原子操作，由平台的hal_types.h定义
+#ifndef HAL_HAS_ATOMICS
+#define HAL_HAS_ATOMICS 0
+#endif
+
+// 为1时事件的置位、清除、读取和调度时取出事件使用原子操作，不进入临界区，
+// 需要平台支持无锁原子操作
+#ifndef OSAL_EVENT_ATOMIC
+#define OSAL_EVENT_ATOMIC HAL_HAS_ATOMICS
+#endif
+
+// 为1时开启最早截止时间优先调度，通过osal_set_event_deadline置位的事件按截止时间调度，
+// 其余事件仍按静态优先级调度
+#ifndef OSAL_SCHED_EDF
+#define OSAL_SCHED_EDF 0
+#endif
+
+// 为1时相同优先级的就绪任务轮流执行，否则总是执行链表中靠前的任务
+#ifndef OSAL_TASK_RR
+#define OSAL_TASK_RR 0
+#endif
+
+// 每次调度最多交给处理函数的事件数量，从上次取到的位的下一位开始向低位轮流取，
+// 其余事件留到下次调度，为0时一次交出全部事件
+#ifndef OSAL_EVENT_BUDGET
+#define OSAL_EVENT_BUDGET 0
+#endif
+
+// 为1时每个任务可以为每个事件位注册一个处理函数
+#ifndef OSAL_EVENT_TABLE
+#define OSAL_EVENT_TABLE 0
+#endif
+
+// 为1时可以用OSAL_TASK_DEFINE静态定义任务，任务控制块放在osal_tasks段中，
+// 由osal_init按优先级加入任务链表，不占用堆
+#ifndef OSAL_TASK_STATIC
+#define OSAL_TASK_STATIC 0
+#endif
+
 // 虚拟任务控制块
 struct osal_tcb;
 
@@ -19,7 +81,8 @@ struct osal_tcb;
 typedef void (*task_init_fn_t)(struct osal_tcb *task);
 
 // 任务事件处理函数
-typedef uint16_t (*task_handler_fn_t)(struct osal_tcb *task, uint16_t event);
+typedef osal_event_t (*task_handler_fn_t)(struct osal_tcb *task,
+                                          osal_event_t event);
 
 /**
  * @brief 添加一个任务
@@ -28,10 +91,10 @@ typedef uint16_t (*task_handler_fn_t)(struct osal_tcb *task, uint16_t event);
  * @param handler   任务事件处理函数
  * @param task_priority 任务优先级
  *
- * @return uint8_t 任务id
+ * @return struct osal_tcb* 任务指针，失败返回NULL
  */
-uint8_t osal_add_task(task_init_fn_t init, task_handler_fn_t handler,
-                      uint8_t priority);
+struct osal_tcb *osal_add_task(task_init_fn_t init, task_handler_fn_t handler,
+                               uint8_t priority);
 
 /**
  * @brief 初始化任务列表
@@ -39,6 +102,16 @@ uint8_t osal_add_task(task_init_fn_t init, task_handler_fn_t handler,
  */
 void osal_task_init(void);
 
+#if OSAL_TASK_STATIC
+/**
+ * @brief 将OSAL_TASK_DEFINE定义的静态任务按优先级加入任务链表，由osal_init调用
+ *
+ * @return uint8_t 成功返回OSAL_OK，静态任务超过OSAL_MAX_TASKS时一个也不加入，
+ * 返回OSAL_TOO_MANY_TASKS
+ */
+uint8_t osal_task_register_static(void);
+#endif
+
 /**
  * @brief 调用所有任务的初始化函数
  *
@@ -51,6 +124,22 @@ void osal_task_runinit(void);
  */
 void osal_task_polling(void);
 
+#if OSAL_WORKERS
+/**
+ * @brief 启动工作线程调度任务，当前线程作为0号工作线程，此函数不会返回
+ * 由osal_run调用
+ *
+ */
+void osal_task_run_workers(void);
+#endif
+
+/**
+ * @brief 获取当前正在执行事件处理函数或初始化函数的任务
+ *
+ * @return struct osal_tcb* 当前任务，不在任务上下文中时返回NULL
+ */
+struct osal_tcb *osal_task_self(void);
+
 /**
  * @brief 获取最高优先级的就绪任务
  *
@@ -60,36 +149,56 @@ struct osal_tcb *osal_next_active_task(void);
 
 /**
  * @brief 设置任务的事件标志，将event_flag与任务的events进行或运算
+ * 任务必须属于当前线程绑定的实例，跨实例置位事件使用osal_event_post
  *
- * @param task_id 任务id
+ * @param task 任务
  * @param event_flag 期望设置的事件
- * @return int8 成功返回0
  */
-int8_t osal_set_event(struct osal_tcb *task, uint16_t event_flag);
+void osal_set_event(struct osal_tcb *task, osal_event_t event_flag);
 
 /**
  * @brief 清除任务的事件标志
  *
- * @param task_id 任务id
+ * @param task 任务
  * @param event_flag 期望清除的事件
- * @return int8 成功返回0
  */
-int8_t osal_clear_event(struct osal_tcb *task, uint16_t event_flag);
+void osal_clear_event(struct osal_tcb *task, osal_event_t event_flag);
 
 /**
  * @brief 获取任务事件标志
  *
  * @param task 任务
 
- * @return uint16_t 事件标志
+ * @return osal_event_t 事件标志
  */
-uint16_t osal_get_event(const struct osal_tcb *task);
+osal_event_t osal_get_event(const struct osal_tcb *task);
 
+#if OSAL_SCHED_EDF
 /**
- * @brief 将消息放到任务的消息列表中
- * 任务消费完消息后负责释放消息缓冲区
- * @param task 任务指针
- * @param msg 消息指针
- * @param len 消息长度
+ * @brief 置位任务的事件并指定截止时间，有截止时间的就绪任务按截止时间从早到晚调度，
+ * 优先于只按静态优先级调度的任务。任务已有更早的截止时间时保持不变，
+ * 任务被调度一次后截止时间清除，处理函数返回的事件按静态优先级调度
+ *
+ * @param task 任务
+ * @param event_flag 期望设置的事件
+ * @param deadline 截止时间，从现在开始的ms数
+ */
+void osal_set_event_deadline(struct osal_tcb *task, osal_event_t event_flag,
+                             uint16_t deadline);
+#endif
+
+#if OSAL_EVENT_TABLE
+/**
+ * @brief 为任务的一个事件位注册处理函数，一般在任务初始化函数中调用
+ * 调度时按从低位到高位的顺序依次调用各事件位的处理函数，一次调度处理完所有事件，
+ * 没有注册处理函数的事件合并后交给osal_add_task传入的任务处理函数
+ *
+ * @param task 任务
+ * @param event 事件，只能有一个位有效
+ * @param handler 处理函数，参数为该事件位，返回需要再次置位的事件，NULL表示取消注册
+ * @return uint8_t 成功返回OSAL_OK，task为NULL时返回OSAL_INVALID_TASK，
+ * event不是单个事件位时返回OSAL_INVALID_EVENT_ID
  */
-void osal_send_msg(struct osal_tcb *task, uint8_t *msg, uint16_t len);
+uint8_t osal_set_event_handler(struct osal_tcb *task, osal_event_t event,
+                               task_handler_fn_t handler);
+#endif
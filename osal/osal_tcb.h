@@ -0,0 +1,116 @@
+/**
+ * @file osal_tcb.h
+ * @author ljgabc
+ * @brief 任务控制块定义
+ * 只供osal内部和OSAL_TASK_DEFINE静态定义任务使用，应用不应直接访问任务控制块的成员
+ * @version 0.1
+ * @date 2024-12-17
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "osal_co.h"
+#include "osal_config.h"
+#include "osal_ctx.h"
+#include "osal_msg.h"
+#include "osal_task.h"
+#include "osal_types.h"
+
+#if OSAL_EVT_RING
+#if OSAL_EVT_RING > 255
+#error "OSAL_EVT_RING must not exceed 255"
+#endif
+
+// 小数据事件，数据直接保存在任务控制块中
+struct osal_evt {
+  uint8_t tag;
+  uint8_t len;
+  uint8_t data[OSAL_EVT_DATA_MAX];
+};
+#endif
+
+/**
+ * @brief 任务控制块实现
+ */
+struct osal_tcb {
+  struct osal_tcb *next;
+  task_init_fn_t init;            // 任务初始化函数指针
+  task_handler_fn_t handler;      // 任务事件处理函数指针
+  struct osal_msg_hdr *msg_head[OSAL_MSG_LANES]; // 各优先级通道的队列头，从这里取出消息
+  struct osal_msg_hdr *msg_tail[OSAL_MSG_LANES]; // 各优先级通道的队列尾，新消息放到这里
+  uint16_t msg_cnt;               // 队列中的消息数量
+  uint16_t msg_max_cnt;           // 队列最多容纳的消息数量，0表示不限制
+  uint32_t msg_bytes;             // 队列中的消息总字节数
+  uint32_t msg_max_bytes;         // 队列最多容纳的消息字节数，0表示不限制
+  uint16_t msg_dropped;           // 因队列已满被丢弃的消息数量
+  uint8_t msg_policy;             // 队列已满时的处理策略
+#if OSAL_MSG_MPSC
+  _Atomic(struct osal_msg_hdr *) inbox; // 无锁收件箱，其他线程投递的消息，后进先出
+  _Atomic osal_event_t post_events;     // 其他线程投递的事件
+#endif
+#if OSAL_EVT_RING
+  struct osal_evt evt_ring[OSAL_EVT_RING]; // 小数据事件环形队列
+  uint8_t evt_head;                        // 队列头，从这里取出事件
+  uint8_t evt_cnt;                         // 队列中的事件数量
+#endif
+#if OSAL_WORKERS
+  struct osal_tcb *ready_next;    // 就绪队列中的下一个任务
+  uint8_t sched_state;            // 调度状态
+  uint8_t worker;                 // 优先执行此任务的工作线程
+#endif
+#if OSAL_MAX_CTX > 1
+  osal_ctx_t ctx;                 // 任务所属的内核实例
+#endif
+#if OSAL_EVENT_TABLE
+  task_handler_fn_t event_fn[OSAL_EVENT_BITS]; // 各事件位的处理函数
+#endif
+#if OSAL_COROUTINE
+  struct osal_co co;              // 协程状态
+#endif
+#if OSAL_SCHED_EDF
+  uint32_t deadline;              // 最早的截止时间，与osal_millis比较
+  uint8_t edf_idx;                // 在截止时间堆中的位置，OSAL_EDF_NONE表示没有截止时间
+#endif
+#if OSAL_EVENT_BUDGET
+  uint8_t event_cursor;           // 下次取事件时开始扫描的位，上次取到的最后一位的下一位
+#endif
+#if OSAL_EVENT_ATOMIC
+  _Atomic osal_event_t events;    // 任务事件，只用原子操作访问
+#else
+  osal_event_t events;            // 任务事件
+#endif
+  uint8_t priority;               // 任务优先级
+};
+
+#if OSAL_TASK_STATIC
+// 静态任务控制块所在的段，GNU ld自动生成__start_osal_tasks和__stop_osal_tasks，
+// 使用自定义链接脚本时需要保留该段(KEEP)并定义这两个符号
+#define OSAL_TASK_SECTION "osal_tasks"
+
+/**
+ * @brief 静态定义一个任务，任务控制块放在OSAL_TASK_SECTION段中，不占用堆，
+ * osal_init时按优先级加入默认实例的任务链表，之后与osal_add_task添加的任务相同，
+ * 调度仍然遍历任务链表。按任务控制块自身对齐，使段中的任务控制块可以按数组遍历
+ * 其他文件中使用时用OSAL_TASK_DECLARE声明，静态任务总数超过OSAL_MAX_TASKS时osal_init失败
+ *
+ * @param name 任务指针名称，类型为struct osal_tcb *const
+ * @param init_fn 任务初始化函数
+ * @param handler_fn 任务事件处理函数
+ * @param prio 任务优先级
+ */
+#define OSAL_TASK_DEFINE(name, init_fn, handler_fn, prio)                      \
+  static struct osal_tcb name##_tcb                                            \
+      __attribute__((used, aligned(__alignof__(struct osal_tcb)),              \
+                     section(OSAL_TASK_SECTION))) = {                          \
+          .init = (init_fn), .handler = (handler_fn), .priority = (prio)};     \
+  struct osal_tcb *const name = &name##_tcb
+
+/**
+ * @brief 声明OSAL_TASK_DEFINE定义的任务
+ *
+ * @param name 任务指针名称
+ */
+#define OSAL_TASK_DECLARE(name) extern struct osal_tcb *const name
+#endif
@@ -3,22 +3,32 @@
 struct osal_timer {
   struct osal_timer *next;
   uint16_t timeout;      // 定时时间，每过一个系统时钟会自减
-  uint16_t event_flag;   // 定时事件，定时时间减完产生任务事件
+  osal_event_t event_flag; // 定时事件，定时时间减完产生任务事件
   uint16_t reload;       // 重装定时时间
   struct osal_tcb *task; // 响应的任务ID
 };
 
-static uint32_t osal_current_time;         // 记录系统时钟
-static struct osal_timer *timer_list_head; // 任务定时器链表头指针
-static uint8_t total_timer_cnt = 0;        // 定时器总数
+// 定时器模块状态，每个内核实例一份
+struct osal_timer_state {
+  uint32_t osal_current_time;         // 记录系统时钟
+  struct osal_timer *timer_list_head; // 任务定时器链表头指针
+  uint8_t total_timer_cnt;            // 定时器总数
+};
+
+static struct osal_timer_state timer_state[OSAL_MAX_CTX];
+
+// 当前内核实例的定时器模块状态
+#define osal_current_time (timer_state[osal_ctx_current()].osal_current_time)
+#define timer_list_head (timer_state[osal_ctx_current()].timer_list_head)
+#define total_timer_cnt (timer_state[osal_ctx_current()].total_timer_cnt)
 
 /*********************************************************************
  * LOCAL FUNCTION PROTOTYPES
  */
 struct osal_timer *osal_add_timer(const struct osal_tcb *task,
-                                  uint16_t event_flag, uint16_t timeout);
+                                  osal_event_t event_flag, uint16_t timeout);
 struct osal_timer *osal_find_timer(const struct osal_tcb *task,
-                                   uint16_t event_flag);
+                                   osal_event_t event_flag);
 void osal_delete_timer(struct osal_timer *rmTimer);
 
 /*********************************************************************
@@ -34,11 +44,14 @@ void osal_timer_init(void) {
   osal_current_time = 0;
   total_timer_cnt = 0;
 
-  // 初始化硬件定时器
-  hal_tick_init();
+  // 硬件定时器只有一个，由默认实例初始化，多实例时通过osal_ctx_tick_all更新所有实例
+  if (osal_ctx_current() == OSAL_DEFAULT_CTX) {
+    // 初始化硬件定时器
+    hal_tick_init();
 
-  // 启动硬件定时器
-  hal_tick_start();
+    // 启动硬件定时器
+    hal_tick_start();
+  }
 }
 
 /*********************************************************************
@@ -54,7 +67,7 @@ void osal_timer_init(void) {
  * @return  struct osal_timer * - pointer to newly created timer
  */
 struct osal_timer *osal_add_timer(const struct osal_tcb *task,
-                                  uint16_t event_flag, uint16_t timeout) {
+                                  osal_event_t event_flag, uint16_t timeout) {
   // Look for an existing timer first
   struct osal_timer *timer_new = osal_find_timer(task, event_flag);
 
@@ -101,7 +114,7 @@ struct osal_timer *osal_add_timer(const struct osal_tcb *task,
  * @return struct osal_timer*
  */
 struct osal_timer *osal_find_timer(const struct osal_tcb *task,
-                                   uint16_t event_flag) {
+                                   osal_event_t event_flag) {
   struct osal_timer *timer_ptr = timer_list_head;
 
   for (; timer_ptr != NULL; timer_ptr = timer_ptr->next) {
@@ -135,7 +148,7 @@ void osal_delete_timer(struct osal_timer *timer) {
  *
  * @return uint8_t 成功返回OK
  */
-uint8_t osal_start_timer(const struct osal_tcb *task, uint16_t event_id,
+uint8_t osal_start_timer(const struct osal_tcb *task, osal_event_t event_id,
                          uint16_t timeout, bool oneshot) {
   struct osal_timer *timer_new;
 
@@ -163,7 +176,7 @@ uint8_t osal_start_timer(const struct osal_tcb *task, uint16_t event_id,
  * @param event_id 事件ID
  * @return uint8_t 成功返回OK
  */
-uint8_t osal_stop_timer(const struct osal_tcb *task, uint16_t event_id) {
+uint8_t osal_stop_timer(const struct osal_tcb *task, osal_event_t event_id) {
   struct osal_timer *foundTimer;
 
   // 进入临界区
@@ -191,7 +204,7 @@ uint8_t osal_stop_timer(const struct osal_tcb *task, uint16_t event_id) {
  * @return uint16_t 超时时间
  */
 uint16_t osal_timer_get_timeout(const struct osal_tcb *task,
-                                uint16_t event_id) {
+                                osal_event_t event_id) {
   uint16_t rtrn = 0;
   struct osal_timer *tmr;
 
@@ -233,6 +246,11 @@ void osal_tick(uint16_t ms) {
   osal_current_time += ms;
   hal_exit_critical(cpusr);
 
+#if OSAL_MAX_CALLS
+  // 更新请求/应答调用的超时时间
+  osal_rpc_tick(ms);
+#endif
+
   // 更新定时器状态
   if (timer_list_head != NULL) {
     struct osal_timer *timer_ptr = timer_list_head;
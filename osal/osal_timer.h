@@ -21,7 +21,7 @@ void osal_timer_init(void);
  *
  * @return uint8_t 成功返回OK
  */
-uint8_t osal_start_timer(const struct osal_tcb* task, uint16_t event_id, uint16_t timeout,
+uint8_t osal_start_timer(const struct osal_tcb* task, osal_event_t event_id, uint16_t timeout,
                          bool oneshot);
 
 /**
@@ -31,7 +31,7 @@ uint8_t osal_start_timer(const struct osal_tcb* task, uint16_t event_id, uint16_
  * @param event_id 事件ID
  * @return uint8_t 成功返回OK
  */
-uint8_t osal_stop_timer(const struct osal_tcb* task, uint16_t event_id);
+uint8_t osal_stop_timer(const struct osal_tcb* task, osal_event_t event_id);
 
 /**
  * @brief 获取定时器的timeout
@@ -40,7 +40,7 @@ uint8_t osal_stop_timer(const struct osal_tcb* task, uint16_t event_id);
  * @param event_id 事件ID
  * @return uint16_t 超时时间
  */
-uint16_t osal_timer_get_timeout(const struct osal_tcb* task, uint16_t event_id);
+uint16_t osal_timer_get_timeout(const struct osal_tcb* task, osal_event_t event_id);
 
 /**
  * @brief 当前活跃定时器数量
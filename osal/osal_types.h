@@ -37,6 +37,16 @@ typedef int8_t os_base_t;
 #define OSAL_NO_TIMER_AVAIL 5
 #define OSAL_TASK_NO_TASK 6
 #define OSAL_MSG_BUFFER_NOT_AVAIL 7
+#define OSAL_INVALID_TOPIC 8
+#define OSAL_MSG_QUEUE_FULL 9
+#define OSAL_MSG_DROPPED 10
+#define OSAL_MSG_TOO_LONG 11
+#define OSAL_RPC_TIMEOUT 12
+#define OSAL_RPC_NO_CALL 13
+#define OSAL_WORK_QUEUE_FULL 14
+#define OSAL_INVALID_CTX_ID 15
+#define OSAL_MSG_EMPTY 16
+#define OSAL_TOO_MANY_TASKS 17
 
 #define OSAL_INVALID_TASK_ID 0xFF
 
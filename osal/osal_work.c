@@ -0,0 +1,202 @@
+/**
+ * @file osal_work.c
+ * @author ljgabc
+ * @brief 延迟工作队列
+ * 平台支持原子操作时使用有界多生产者队列，每个位置带序号，投递只需一次比较交换，
+ * 否则投递时进入临界区
+ * @version 0.1
+ * @date 2024-12-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "osal.h"
+
+#if OSAL_WORK_RING
+
+#if (OSAL_WORK_RING & (OSAL_WORK_RING - 1)) != 0
+#error "OSAL_WORK_RING must be a power of 2"
+#endif
+
+#if HAL_HAS_ATOMICS
+#include <stdatomic.h>
+#endif
+
+// 内部任务的工作事件
+#define OSAL_WORK_EVENT 0x0001
+
+// 延迟工作
+struct osal_work_item {
+#if HAL_HAS_ATOMICS
+  atomic_uint seq; // 位置序号，等于投递位置时可写入，等于投递位置加1时可取出
+#endif
+  osal_work_fn_t fn; // 工作函数
+  void *arg;         // 工作函数参数
+};
+
+// 延迟工作模块状态，每个内核实例一份
+struct osal_work_state {
+  struct osal_work_item ring[OSAL_WORK_RING]; // 工作队列
+#if HAL_HAS_ATOMICS
+  atomic_uint head; // 下一个投递位置
+#else
+  unsigned head; // 下一个投递位置，受临界区保护
+#endif
+  unsigned tail;          // 下一个取出位置，只在内部任务中访问
+  struct osal_tcb *task;  // 执行延迟工作的内部任务
+};
+
+static struct osal_work_state work_state[OSAL_MAX_CTX];
+
+// 当前内核实例的延迟工作模块状态
+#define work_ring (work_state[osal_ctx_current()].ring)
+#define work_head (work_state[osal_ctx_current()].head)
+#define work_tail (work_state[osal_ctx_current()].tail)
+#define work_task (work_state[osal_ctx_current()].task)
+
+/*********************************************************************
+ * LOCAL FUNCTION PROTOTYPES
+ */
+static osal_event_t osal_work_handler(struct osal_tcb *task,
+                                      osal_event_t events);
+
+/**
+ * @brief 初始化延迟工作队列，创建执行延迟工作的内部任务
+ *
+ * @return uint8_t 成功返回OSAL_OK，创建任务失败返回OSAL_TASK_NO_TASK
+ */
+uint8_t osal_work_init(void) {
+#if HAL_HAS_ATOMICS
+  for (unsigned i = 0; i < OSAL_WORK_RING; i++) {
+    atomic_init(&work_ring[i].seq, i);
+  }
+  atomic_init(&work_head, 0);
+#else
+  work_head = 0;
+#endif
+  work_tail = 0;
+
+  work_task = osal_add_task(NULL, osal_work_handler, OSAL_WORK_PRIORITY);
+  return work_task ? OSAL_OK : OSAL_TASK_NO_TASK;
+}
+
+/**
+ * @brief 投递一个延迟工作，可以在中断或其他线程中调用
+ * 工作投递到当前线程绑定的实例，中断和没有绑定的线程投递到默认实例
+ *
+ * @param fn 工作函数
+ * @param arg 工作函数参数
+ * @return uint8_t 成功返回OSAL_OK，队列已满返回OSAL_WORK_QUEUE_FULL
+ */
+uint8_t osal_post_work(osal_work_fn_t fn, void *arg) {
+#if HAL_HAS_ATOMICS
+  // 抢占投递位置，位置上的工作还没被取出时队列已满
+  struct osal_work_item *item;
+  unsigned pos = atomic_load_explicit(&work_head, memory_order_relaxed);
+  for (;;) {
+    item = &work_ring[pos & (OSAL_WORK_RING - 1)];
+    const unsigned seq =
+        atomic_load_explicit(&item->seq, memory_order_acquire);
+    const int diff = (int)(seq - pos);
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&work_head, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return OSAL_WORK_QUEUE_FULL;
+    } else {
+      pos = atomic_load_explicit(&work_head, memory_order_relaxed);
+    }
+  }
+
+  item->fn = fn;
+  item->arg = arg;
+  atomic_store_explicit(&item->seq, pos + 1, memory_order_release);
+#else
+  hal_reg_t cpu_sr = hal_enter_critical();
+  if (work_head - work_tail >= OSAL_WORK_RING) {
+    hal_exit_critical(cpu_sr);
+    return OSAL_WORK_QUEUE_FULL;
+  }
+  struct osal_work_item *item = &work_ring[work_head & (OSAL_WORK_RING - 1)];
+  item->fn = fn;
+  item->arg = arg;
+  work_head++;
+  hal_exit_critical(cpu_sr);
+#endif
+
+  osal_set_event(work_task, OSAL_WORK_EVENT);
+  return OSAL_OK;
+}
+
+/**
+ * @brief 向指定实例投递一个延迟工作，可以在中断或任意线程中调用
+ * 投递期间临时切换到目标实例，队列、临界区和内部任务都按目标实例选择
+ *
+ * @param ctx 实例
+ * @param fn 工作函数
+ * @param arg 工作函数参数
+ * @return uint8_t 成功返回OSAL_OK，队列已满返回OSAL_WORK_QUEUE_FULL，
+ * 实例无效返回OSAL_INVALID_CTX_ID
+ */
+uint8_t osal_post_work_ctx(osal_ctx_t ctx, osal_work_fn_t fn, void *arg) {
+  if (ctx >= osal_ctx_count()) {
+    return OSAL_INVALID_CTX_ID;
+  }
+
+#if OSAL_MAX_CTX > 1
+  const osal_ctx_t self = osal_ctx_cur;
+  osal_ctx_cur = ctx;
+  const uint8_t ret = osal_post_work(fn, arg);
+  osal_ctx_cur = self;
+  return ret;
+#else
+  return osal_post_work(fn, arg);
+#endif
+}
+
+/**
+ * @brief 内部任务的事件处理函数，依次执行已投递的工作
+ * 每次最多执行一圈队列容量的工作，剩余的工作留到下次调度，避免长期占用
+ *
+ * @param task 内部任务
+ * @param events 事件
+ * @return osal_event_t 还有工作时返回OSAL_WORK_EVENT
+ */
+static osal_event_t osal_work_handler(struct osal_tcb *task,
+                                      osal_event_t events) {
+  (void)task;
+  (void)events;
+
+  for (unsigned n = 0; n < OSAL_WORK_RING; n++) {
+    struct osal_work_item *item = &work_ring[work_tail & (OSAL_WORK_RING - 1)];
+#if HAL_HAS_ATOMICS
+    // 投递者写完后才会更新序号，未完成的投递由投递者稍后置位事件
+    if (atomic_load_explicit(&item->seq, memory_order_acquire) !=
+        work_tail + 1) {
+      return 0;
+    }
+    const osal_work_fn_t fn = item->fn;
+    void *const arg = item->arg;
+    atomic_store_explicit(&item->seq, work_tail + OSAL_WORK_RING,
+                          memory_order_release);
+    work_tail++;
+#else
+    hal_reg_t cpu_sr = hal_enter_critical();
+    if (work_head == work_tail) {
+      hal_exit_critical(cpu_sr);
+      return 0;
+    }
+    const osal_work_fn_t fn = item->fn;
+    void *const arg = item->arg;
+    work_tail++;
+    hal_exit_critical(cpu_sr);
+#endif
+    fn(arg);
+  }
+  return OSAL_WORK_EVENT;
+}
+
+#endif
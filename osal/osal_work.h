@@ -0,0 +1,62 @@
+/**
+ * @file osal_work.h
+ * @author ljgabc
+ * @brief 延迟工作队列
+ * 中断或其他线程通过osal_post_work投递{函数, 参数}，不需要为每个中断源创建任务，
+ * osal主循环在OSAL_WORK_PRIORITY优先级的内部任务中依次执行投递的函数。
+ * 每个内核实例有独立的队列，中断和没有绑定实例的线程默认投递到默认实例
+ * @version 0.1
+ * @date 2024-12-15
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include "osal_config.h"
+#include "osal_ctx.h"
+#include "osal_types.h"
+
+// 延迟工作队列容量，必须是2的幂，为0时不使用此功能
+#ifndef OSAL_WORK_RING
+#define OSAL_WORK_RING 0
+#endif
+
+// 执行延迟工作的内部任务优先级
+#ifndef OSAL_WORK_PRIORITY
+#define OSAL_WORK_PRIORITY 255
+#endif
+
+// 延迟工作函数
+typedef void (*osal_work_fn_t)(void *arg);
+
+#if OSAL_WORK_RING
+/**
+ * @brief 初始化延迟工作队列，创建执行延迟工作的内部任务
+ *
+ * @return uint8_t 成功返回OSAL_OK，创建任务失败返回OSAL_TASK_NO_TASK
+ */
+uint8_t osal_work_init(void);
+
+/**
+ * @brief 投递一个延迟工作，可以在中断或其他线程中调用
+ * 平台支持原子操作时不进入临界区，fn在osal主循环中以arg为参数执行一次。
+ * 工作投递到当前线程绑定的实例，中断和没有绑定的线程投递到默认实例
+ *
+ * @param fn 工作函数
+ * @param arg 工作函数参数
+ * @return uint8_t 成功返回OSAL_OK，队列已满返回OSAL_WORK_QUEUE_FULL
+ */
+uint8_t osal_post_work(osal_work_fn_t fn, void *arg);
+
+/**
+ * @brief 向指定实例投递一个延迟工作，可以在中断或任意线程中调用
+ *
+ * @param ctx 实例
+ * @param fn 工作函数
+ * @param arg 工作函数参数
+ * @return uint8_t 成功返回OSAL_OK，队列已满返回OSAL_WORK_QUEUE_FULL，
+ * 实例无效返回OSAL_INVALID_CTX_ID
+ */
+uint8_t osal_post_work_ctx(osal_ctx_t ctx, osal_work_fn_t fn, void *arg);
+#endif
@@ -2,49 +2,69 @@
  * @file hal_int_master.c
  * @author ljgabc
  * @brief 临界区控制
+ * Linux平台下没有中断，tick线程和其他线程与osal主循环并发运行，
+ * 使用递归互斥锁模拟关中断，同一线程可以嵌套进入临界区。
+ * 每个内核实例一把锁，不同实例的临界区互不影响
  * @version 0.1
  * @date 2024-11-25
  * 
  * @copyright Copyright (c) 2024
  * 
  */
+#define _GNU_SOURCE
+#include <pthread.h>
+
 #include "osal.h"
 
-// #define HAL_ENABLE_INTERRUPTS()         SEI()       // Enable Interrupts
-// #define HAL_DISABLE_INTERRUPTS()        CLI()       // Disable Interrupts
-// #define HAL_INTERRUPTS_ARE_ENABLED()    SEI()       // Enable Interrupts
+// 模拟全局中断的递归互斥锁，每个内核实例一把
+static pthread_mutex_t hal_critical_mutex[OSAL_MAX_CTX] = {
+    [0 ... OSAL_MAX_CTX - 1] = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP};
 
-// #define HAL_ENTER_CRITICAL_SECTION()    CLI()
-// #define HAL_EXIT_CRITICAL_SECTION()     SEI()
+// 当前线程进入临界区的嵌套深度
+static _Thread_local uint32_t hal_critical_depth = 0;
 
 /**
  * @brief 使能全局中断
  * 
  */
-void hal_enable_interrupt(void);
+void hal_enable_interrupt(void) {
+  if (hal_critical_depth > 0) {
+    hal_critical_depth--;
+    pthread_mutex_unlock(&hal_critical_mutex[osal_ctx_current()]);
+  }
+}
 
 /**
  * @brief 禁用全局中断
  * 
  */
-void hal_disable_interrupt(void);
+void hal_disable_interrupt(void) {
+  pthread_mutex_lock(&hal_critical_mutex[osal_ctx_current()]);
+  hal_critical_depth++;
+}
 
 /**
  * @brief 查询中断是否使能
  * 
  */
-bool hal_interrupt_enabled(void);
+bool hal_interrupt_enabled(void) { return hal_critical_depth == 0; }
 
 /**
  * @brief 禁用全局中断，并保存当前中断使能状态
  * 
  * @return hal_reg_t 
  */
-hal_reg_t hal_enter_critical(void);
+hal_reg_t hal_enter_critical(void) {
+  hal_disable_interrupt();
+  return (hal_reg_t)hal_critical_depth;
+}
 
 /**
  * @brief 根据cpu_sr的值，恢复中断使能状态
  * 
  * @param cpu_sr 
  */
-void hal_exit_critical(hal_reg_t cpu_sr);
+void hal_exit_critical(hal_reg_t cpu_sr) {
+  (void)cpu_sr;
+  hal_enable_interrupt();
+}
@@ -0,0 +1,75 @@
+/**
+ * @file hal_mem_persist.c
+ * @author ljgabc
+ * @brief Linux平台下持久化内存区域实现，使用共享内存文件保存堆
+ * @version 0.1
+ * @date 2024-12-03
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include "osal.h"
+
+#if OSALMEM_PERSIST
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * @brief 持久化区域文件，放在/dev/shm下重启程序后数据仍然保留
+ *
+ */
+#ifndef HAL_MEM_PERSIST_PATH
+#define HAL_MEM_PERSIST_PATH "/dev/shm/osal_heap"
+#endif
+
+/**
+ * @brief 期望的映射地址，每次映射到相同地址时持久数据中的指针才有效
+ *
+ */
+#ifndef HAL_MEM_PERSIST_ADDR
+#define HAL_MEM_PERSIST_ADDR ((void *)0x7e0000000000UL)
+#endif
+
+/**
+ * @brief 映射持久化内存区域，文件新建时内容全部为0
+ *
+ * @param size 区域大小
+ * @return void* 区域地址
+ */
+void *hal_mem_persist_map(uint32_t size) {
+  int fd = open(HAL_MEM_PERSIST_PATH, O_RDWR | O_CREAT, 0600);
+  if (fd < 0) {
+    perror("Open hal persist memory error");
+    exit(1);
+  }
+
+  if (ftruncate(fd, size) != 0) {
+    perror("Resize hal persist memory error");
+    exit(1);
+  }
+
+  int flags = MAP_SHARED;
+#ifdef MAP_FIXED_NOREPLACE
+  flags |= MAP_FIXED_NOREPLACE;
+#endif
+
+  void *addr =
+      mmap(HAL_MEM_PERSIST_ADDR, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+#ifdef MAP_FIXED_NOREPLACE
+  // 期望地址已被占用时由内核选择地址，osal会重新格式化堆
+  if (addr == MAP_FAILED) {
+    addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+#endif
+  close(fd);
+
+  if (addr == MAP_FAILED) {
+    perror("Map hal persist memory error");
+    exit(1);
+  }
+  return addr;
+}
+#endif
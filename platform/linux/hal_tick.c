@@ -15,7 +15,7 @@
 #include <unistd.h>
 
 #include "hal_tick.h"
-#include "osal_timer.h"
+#include "osal.h"
 
 static pthread_t hal_timer_pthread_fd;
 
@@ -26,7 +26,7 @@ static void *hal_timer_pthread(void *pro) {
   pro = pro;
   while (1) {
     usleep(HAL_TICK_PERIOD_MS * 1000UL);
-    osal_update_timers();
+    osal_ctx_tick_all(HAL_TICK_PERIOD_MS);
   }
   return 0;
 }
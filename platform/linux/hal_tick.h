@@ -2,7 +2,7 @@
  * @file hal_timer.h
  * @author ljgabc
  * @brief 硬件定时器实现，为osal操作系统提供系统滴答心跳时钟
- * 每次系统滴答心跳时调用一次osal_update_timers()
+ * 每次系统滴答心跳时调用一次osal_ctx_tick_all()，更新所有内核实例
  * @version 0.1
  * @date 2024-11-25
  *
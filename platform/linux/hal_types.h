@@ -21,3 +21,6 @@ typedef uint32_t hal_reg_t;
 
 // 平台字类型
 typedef uint32_t hal_word_t;
+
+// 平台支持C11无锁原子操作
+#define HAL_HAS_ATOMICS 1
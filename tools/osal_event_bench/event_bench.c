@@ -0,0 +1,104 @@
+/**
+ * @file event_bench.c
+ * @author ljgabc
+ * @brief 事件置位性能测试工具
+ * 多个生产线程（模拟tick线程、网络线程）不断置位任务事件，主线程调度任务处理事件，
+ * 输出：每秒置位次数 每秒调度次数
+ * 编译时BENCH_ATOMIC为0使用临界区，为1使用原子操作，
+ * 一般不直接使用，由osal_event_bench.sh分别编译两种方式并运行
+ * 用法：event_bench [生产线程数量] [每个线程置位次数]
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+// 使用宿主机的字长
+typedef uint32_t halDataAlign_t;
+
+#define OSAL_ASSERT(expr)
+#define HAL_ASSERT(expr)
+
+#include "osal_config.h"
+
+#undef OSAL_EVENT_ATOMIC
+#define OSAL_EVENT_ATOMIC BENCH_ATOMIC
+
+#include "osal_memory.c"
+#include "osal_task.c"
+
+#define BENCH_TASKS 4
+
+static struct osal_tcb *bench_tasks[BENCH_TASKS];
+static uint32_t bench_ops = 1000000;
+static atomic_int bench_running;
+static unsigned long bench_dispatch;
+
+static osal_event_t bench_handler(struct osal_tcb *task, osal_event_t events) {
+  (void)task;
+  (void)events;
+  bench_dispatch++;
+  return 0;
+}
+
+static void *bench_producer(void *arg) {
+  const uint32_t seed = (uint32_t)(uintptr_t)arg;
+  for (uint32_t i = 0; i < bench_ops; i++) {
+    osal_set_event(bench_tasks[(i + seed) % BENCH_TASKS],
+                   (osal_event_t)1 << (i % 8));
+  }
+  atomic_fetch_sub(&bench_running, 1);
+  return NULL;
+}
+
+static double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+  int producers = 2;
+  if (argc > 1) {
+    producers = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    bench_ops = (uint32_t)strtoul(argv[2], NULL, 0);
+  }
+
+  osal_mem_init();
+  osal_task_init();
+  for (int i = 0; i < BENCH_TASKS; i++) {
+    bench_tasks[i] = osal_add_task(NULL, bench_handler, 1);
+  }
+  osal_mem_kick();
+
+  pthread_t *threads = calloc((size_t)producers, sizeof(pthread_t));
+  atomic_store(&bench_running, producers);
+  const double start = bench_now();
+  for (int i = 0; i < producers; i++) {
+    pthread_create(&threads[i], NULL, bench_producer, (void *)(uintptr_t)i);
+  }
+
+  // 生产线程结束后继续调度，直到所有事件处理完
+  while ((atomic_load(&bench_running) > 0) || osal_next_active_task()) {
+    osal_task_polling();
+  }
+  const double elapsed = bench_now() - start;
+
+  for (int i = 0; i < producers; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+
+  printf("%.0f %.0f\n", (double)bench_ops * producers / elapsed,
+         (double)bench_dispatch / elapsed);
+  return 0;
+}
@@ -0,0 +1,39 @@
+#!/bin/sh
+#
+# 事件置位性能测试
+# 用法：osal_event_bench.sh [生产线程数量] [每个线程置位次数]
+#
+# 分别按临界区和原子操作(OSAL_EVENT_ATOMIC)编译event_bench并运行，
+# 输出两种方式的每秒置位次数、每秒调度次数以及原子操作的加速比。
+# 原子操作需要平台在hal_types.h中定义HAL_HAS_ATOMICS，这里使用linux平台。
+#
+# 可以通过环境变量CC指定编译器。
+
+PRODUCERS=${1:-2}
+OPS=${2:-1000000}
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+TOP=$DIR/../..
+CC=${CC:-gcc}
+BIN=$(mktemp)
+trap 'rm -f "$BIN"' EXIT
+
+run() {
+  $CC -std=gnu11 -O2 -w -pthread -I "$TOP/osal" -I "$TOP/platform/linux" \
+    -DBENCH_ATOMIC="$1" -o "$BIN" "$DIR/event_bench.c" \
+    "$TOP/platform/linux/hal_int_master.c" ||
+    { echo "build event_bench failed" >&2; exit 1; }
+  "$BIN" "$PRODUCERS" "$OPS"
+}
+
+set -- $(run 0)
+LOCK_SET=$1
+LOCK_DISPATCH=$2
+set -- $(run 1)
+ATOMIC_SET=$1
+ATOMIC_DISPATCH=$2
+
+echo "critical: set/s=$LOCK_SET dispatch/s=$LOCK_DISPATCH"
+echo "atomic:   set/s=$ATOMIC_SET dispatch/s=$ATOMIC_DISPATCH"
+awk -v a="$ATOMIC_SET" -v l="$LOCK_SET" \
+  'BEGIN { printf "speedup: %.2fx\n", a / l }'
@@ -0,0 +1,141 @@
+/**
+ * @file mem_replay.c
+ * @author ljgabc
+ * @brief 内存申请释放记录回放工具
+ * 从标准输入读取OSALMEM_TRACE输出的记录，按编译时指定的小块内存区域参数回放，
+ * 输出：申请失败次数 小块内存未命中次数 最坏查找长度 常驻内存占用
+ * 常驻内存占用是记录中osal_mem_kick时未释放的内存块总长度(包括头部)
+ * 一般不直接使用，由osal_mem_tune.sh按不同参数编译并运行
+ * 使用-b参数时额外输出建议的proCnt[]性能统计档位
+ * @version 0.1
+ * @date 2024-12-02
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 回放时使用宿主机的字长，与目标平台一致时结果最准确
+typedef uint32_t halDataAlign_t;
+
+#define OSAL_ASSERT(expr)
+#define HAL_ASSERT(expr)
+
+#undef OSALMEM_PROFILER
+#define OSALMEM_PROFILER 1
+
+#include "osal_memory.c"
+
+_Static_assert((OSALMEM_SMALLBLK_BUCKET + OSALMEM_HDRSZ * 2) < MAXMEMHEAP,
+               "small-block bucket does not fit in MAXMEMHEAP");
+
+hal_reg_t hal_enter_critical(void) { return 0; }
+
+void hal_exit_critical(hal_reg_t cpu_sr) { (void)cpu_sr; }
+
+// 记录中的数据区偏移到回放时内存地址的映射
+static void *blk_map[MAXMEMHEAP / OSALMEM_HDRSZ];
+
+// 记录中各内存块的长度(包括头部)，与回放参数无关，用于计算常驻内存占用
+static uint32_t trace_len[MAXMEMHEAP / OSALMEM_HDRSZ];
+
+// 按内存块大小统计的申请次数，用于计算proCnt[]建议档位
+static uint32_t blk_hist[MAXMEMHEAP / OSALMEM_HDRSZ + 1];
+
+/**
+ * @brief 按申请次数的分位数输出建议的proCnt[]档位
+ * 第一个档位固定为OSALMEM_SMALL_BLKSZ，最后一个档位固定为65535
+ */
+static void print_buckets(void) {
+  uint32_t total = 0;
+  for (size_t i = OSALMEM_SMALL_BLKSZ / OSALMEM_HDRSZ + 1;
+       i < sizeof(blk_hist) / sizeof(blk_hist[0]); i++) {
+    total += blk_hist[i];
+  }
+
+  unsigned last = OSALMEM_SMALL_BLKSZ;
+  uint32_t acc = 0;
+  uint8_t idx = 1;
+
+  printf("static uint16_t proCnt[OSALMEM_PROMAX] = {\n    OSALMEM_SMALL_BLKSZ");
+  for (size_t i = OSALMEM_SMALL_BLKSZ / OSALMEM_HDRSZ + 1;
+       i < sizeof(blk_hist) / sizeof(blk_hist[0]) && idx < OSALMEM_PROMAX - 1;
+       i++) {
+    acc += blk_hist[i];
+    unsigned len = (unsigned)(i * OSALMEM_HDRSZ);
+    if (total != 0 && acc * (OSALMEM_PROMAX - 1) >= total * idx &&
+        len >= last + OSALMEM_MIN_BLKSZ) {
+      printf(", %u", len);
+      last = len;
+      idx++;
+    }
+  }
+  for (; idx < OSALMEM_PROMAX - 1; idx++) {
+    last += OSALMEM_MIN_BLKSZ;
+    printf(", %u", last);
+  }
+  printf(", 65535};\n");
+}
+
+int main(int argc, char *argv[]) {
+  char line[128];
+  unsigned size, off;
+  unsigned oom = 0, ll = 0;
+  unsigned live = 0; // 记录中当前未释放的内存块总长度
+  bool kicked = false;
+
+  osal_mem_init();
+
+  while (fgets(line, sizeof(line), stdin)) {
+    const char *rec = strstr(line, "osalmem ");
+    if (rec == NULL) {
+      continue;
+    }
+    rec += strlen("osalmem ");
+
+    if (sscanf(rec, "A %u %u", &size, &off) == 2) {
+      // 记录时就失败的申请不回放
+      if (off == 0 || off >= MAXMEMHEAP) {
+        continue;
+      }
+      trace_len[off / OSALMEM_HDRSZ] = OSALMEM_ROUND(size + OSALMEM_HDRSZ);
+      live += trace_len[off / OSALMEM_HDRSZ];
+      void *ptr = osal_mem_alloc((uint16_t)size);
+      if (ptr == NULL) {
+        oom++;
+        continue;
+      }
+      blk_map[off / OSALMEM_HDRSZ] = ptr;
+      blk_hist[((osal_mem_hdr_t *)ptr - 1)->len / OSALMEM_HDRSZ]++;
+    } else if (sscanf(rec, "F %u", &off) == 1) {
+      if (off < MAXMEMHEAP) {
+        live -= trace_len[off / OSALMEM_HDRSZ];
+        trace_len[off / OSALMEM_HDRSZ] = 0;
+      }
+      if (off < MAXMEMHEAP && blk_map[off / OSALMEM_HDRSZ] != NULL) {
+        osal_mem_free(blk_map[off / OSALMEM_HDRSZ]);
+        blk_map[off / OSALMEM_HDRSZ] = NULL;
+      }
+    } else if (rec[0] == 'K') {
+      osal_mem_kick();
+      // 常驻内存占用取记录中此时未释放的内存块总长度，不受回放参数影响，
+      // 常驻内存溢出小块内存区域时按ff1计算会偏小
+      if (!kicked) {
+        ll = live;
+        kicked = true;
+      }
+    }
+  }
+
+  printf("%u %u %u %u\n", oom, proSmallBlkMiss, proSearchMax, ll);
+
+  if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+    print_buckets();
+  }
+  return 0;
+}
@@ -0,0 +1,70 @@
+#!/bin/sh
+#
+# 小块内存区域参数调优工具
+# 用法：osal_mem_tune.sh <trace.log>
+#
+# trace.log为开启OSALMEM_TRACE后程序输出的记录（可以混有其他打印），
+# 工具按不同的OSALMEM_SMALL_BLKSZ、OSALMEM_SMALL_BLKCNT组合回放记录，
+# 依次按申请失败次数、最坏查找长度、小块内存未命中次数排序，输出最优的配置。
+# OSALMEM_LL_BLKSZ取记录中osal_mem_kick时未释放内存块的总长度(包括头部)，
+# 与候选参数无关，所有候选配置都按这个值回放。
+#
+# 可以通过环境变量CC指定编译器，BLKSZ_LIST、BLKCNT_LIST指定候选参数。
+
+TRACE=$1
+if [ ! -f "$TRACE" ]; then
+  echo "usage: $0 <trace.log>" >&2
+  exit 1
+fi
+
+DIR=$(cd "$(dirname "$0")" && pwd)
+TOP=$DIR/../..
+CC=${CC:-gcc}
+BLKSZ_LIST=${BLKSZ_LIST:-"8 12 16 24 32 48 64"}
+BLKCNT_LIST=${BLKCNT_LIST:-"4 8 12 16 24 32 48 64"}
+BIN=$(mktemp)
+trap 'rm -f "$BIN"' EXIT
+
+build() {
+  $CC -std=gnu11 -O1 -w -I "$TOP/osal" -I "$TOP/platform/linux" "$@" \
+    -o "$BIN" "$DIR/mem_replay.c" 2>/dev/null
+}
+
+# 默认参数回放一次，从记录中得到常驻内存的占用
+build || { echo "build mem_replay failed" >&2; exit 1; }
+set -- $("$BIN" < "$TRACE")
+LL=$4
+echo "default: oom=$1 miss=$2 search_max=$3 ll=$LL"
+
+# 记录中没有osal_mem_kick时保持默认的常驻内存大小
+if [ "$LL" -gt 0 ]; then
+  LL_OPT="-DOSALMEM_LL_BLKSZ=$LL"
+else
+  LL_OPT=""
+fi
+
+BEST=$(
+  for blksz in $BLKSZ_LIST; do
+    for blkcnt in $BLKCNT_LIST; do
+      build $LL_OPT -DOSALMEM_SMALL_BLKSZ="$blksz" \
+        -DOSALMEM_SMALL_BLKCNT="$blkcnt" || continue
+      echo "$blksz $blkcnt $("$BIN" < "$TRACE")"
+    done
+  done | sort -n -k3,3 -k5,5 -k4,4 -k2,2 | head -n 1
+)
+
+if [ -z "$BEST" ]; then
+  echo "no candidate geometry fits in MAXMEMHEAP" >&2
+  exit 1
+fi
+
+set -- $BEST
+echo "best:    oom=$3 miss=$4 search_max=$5 ll=$LL"
+echo
+echo "#define OSALMEM_SMALL_BLKSZ $1"
+echo "#define OSALMEM_SMALL_BLKCNT $2"
+[ -n "$LL_OPT" ] && echo "#define OSALMEM_LL_BLKSZ $LL"
+echo
+
+build $LL_OPT -DOSALMEM_SMALL_BLKSZ="$1" \
+  -DOSALMEM_SMALL_BLKCNT="$2" && "$BIN" -b < "$TRACE" | tail -n +2